@@ -0,0 +1,33 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../bench/pq_bench.cpp 
+
+BENCH_OBJS += \
+./bench/pq_bench.o 
+
+BENCH_AVX2_OBJS += \
+./bench/pq_bench_avx2.o 
+
+CPP_DEPS += \
+./bench/pq_bench.d \
+./bench/pq_bench_avx2.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+bench/%.o: ../bench/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C++ Compiler'
+	g++ -I../include -O2 -Wall -c -fmessage-length=0 -std=c++17 -pthread -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+bench/%_avx2.o: ../bench/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C++ Compiler'
+	g++ -I../include -O2 -Wall -c -fmessage-length=0 -std=c++17 -pthread -mavx2 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
@@ -13,6 +13,9 @@ CXX_SRCS :=
 C++_SRCS := 
 CC_SRCS := 
 OBJS := 
+BENCH_OBJS := 
+BENCH_AVX2_OBJS := 
+TEST_OBJS := 
 C++_DEPS := 
 C_DEPS := 
 CC_DEPS := 
@@ -24,4 +27,6 @@ C_UPPER_DEPS :=
 # Every subdirectory with source files must be described here
 SUBDIRS := \
 src \
+bench \
+test \
 
@@ -0,0 +1,23 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../test/pq_test.cpp 
+
+TEST_OBJS += \
+./test/pq_test.o 
+
+CPP_DEPS += \
+./test/pq_test.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+test/%.o: ../test/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C++ Compiler'
+	g++ -I../include -O2 -Wall -c -fmessage-length=0 -std=c++17 -pthread -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
@@ -0,0 +1,1319 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <iomanip>
+using std::setw;
+using std::left;
+using std::right;
+using std::fixed;
+using std::setprecision;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <utility>
+using std::pair;
+#include <random>
+using std::mt19937;
+using std::uniform_int_distribution;
+#include <chrono>
+using std::chrono::duration;
+using std::chrono::steady_clock;
+#include <stdexcept>
+using std::invalid_argument;
+using std::out_of_range;
+#include <algorithm>
+using std::min;
+using std::sort;
+#include <queue>
+using std::priority_queue;
+#include <fstream>
+using std::ifstream;
+using std::ofstream;
+#include <type_traits>
+using std::conditional;
+#include <iterator>
+using std::back_inserter;
+#include <functional>
+#include <thread>
+using std::thread;
+#include <mutex>
+using std::mutex;
+using std::lock_guard;
+#include <malloc.h>
+#include <memory_resource>
+using std::pmr::memory_resource;
+using std::pmr::monotonic_buffer_resource;
+
+#include "PriorityQueue.hpp"
+#include "StaticPriorityQueue.hpp"
+#include "BoundedPriorityQueue.hpp"
+#include "MultiQueue.hpp"
+#include "BlockingPriorityQueue.hpp"
+#include "BucketQueue.hpp"
+#include "RadixHeap.hpp"
+#include "TimerScheduler.hpp"
+
+/**
+ * Micro-benchmarks for PriorityQueue.
+ */
+namespace bench {
+
+static const size_t DEFAULT_N = 1000000;
+static const int DEFAULT_REPS = 3;
+static const size_t BATCH_SIZE = 64;
+static const int SMALL_RANGE = 100;
+static const size_t SMALL_QUEUE_SIZE = 100;
+static const size_t ARENA_SIZE = 1 << 16;
+static const size_t TOP_K = 100;
+static const size_t NUM_SOURCES = 4;
+static const size_t WORK_QUEUE_BOUND = 4096;
+static const int TIMER_SPAN = 1 << 16; // in ticks
+static const unsigned SEED = 20140214;
+static const double NANOS_PER_SECOND = 1e9;
+static const size_t LAP_OPS = 64; // operations timed together
+static const int DUPLICATE_RANGE = 16;
+static const double BYTES_PER_MB = 1 << 20;
+
+/**
+ * Returns `n` pseudo-random priorities. The same `n` always gives the same
+ * priorities, so runs are comparable.
+ */
+vector<int> randomPriorities(size_t n) {
+	mt19937 rng(SEED);
+	uniform_int_distribution<int> dist(0, 1 << 20);
+	vector<int> priorities(n);
+	for(size_t i = 0; i < n; i++) {
+		priorities[i] = dist(rng);
+	}
+	return priorities;
+}
+
+/**
+ * Inserts every priority, then pops until empty.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t fillDrain(const vector<int>& priorities) {
+	Queue queue(priorities.size());
+	for(size_t i = 0; i < priorities.size(); i++) {
+		queue.insert(i, priorities[i]);
+	}
+	while(!queue.empty()) {
+		queue.pop();
+	}
+	return 2 * priorities.size();
+}
+
+/**
+ * Loads every priority with one `insert_range()`, then pops until empty.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t bulkDrain(const vector<int>& priorities) {
+	vector<pair<size_t, int> > entries(priorities.size());
+	for(size_t i = 0; i < priorities.size(); i++) {
+		entries[i] = pair<size_t, int>(i, priorities[i]);
+	}
+
+	Queue queue(entries.begin(), entries.end(), entries.size());
+	while(!queue.empty()) {
+		queue.pop();
+	}
+	return 2 * priorities.size();
+}
+
+/**
+ * Inserts every priority, then empties the queue with `pop_n()` batches of
+ * `BATCH_SIZE` elements.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t batchDrain(const vector<int>& priorities) {
+	Queue queue(priorities.size());
+	for(size_t i = 0; i < priorities.size(); i++) {
+		queue.insert(i, priorities[i]);
+	}
+	vector<size_t> batch(BATCH_SIZE);
+	while(!queue.empty()) {
+		queue.pop_n(BATCH_SIZE, batch.begin());
+	}
+	return 2 * priorities.size();
+}
+
+/**
+ * Inserts every priority, then empties the queue with one `drain()`.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t fullDrain(const vector<int>& priorities) {
+	Queue queue(priorities.size());
+	for(size_t i = 0; i < priorities.size(); i++) {
+		queue.insert(i, priorities[i]);
+	}
+	vector<size_t> sorted(priorities.size());
+	queue.drain(sorted.begin());
+	return 2 * priorities.size();
+}
+
+/**
+ * Inserts every priority, raises each item's priority through its handle,
+ * as Dijkstra's algorithm does when it finds a shorter path, then pops
+ * until empty.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t raiseKey(const vector<int>& priorities) {
+	size_t n = priorities.size();
+	Queue queue(n);
+	vector<typename Queue::Handle> handles(n);
+	for(size_t i = 0; i < n; i++) {
+		handles[i] = queue.insert(i, priorities[i]);
+	}
+	for(size_t i = 0; i < n; i++) {
+		queue.update(handles[i], priorities[i] + priorities[n - 1 - i]);
+	}
+	while(!queue.empty()) {
+		queue.pop();
+	}
+	return 3 * n;
+}
+
+/**
+ * Inserts every priority, removes three items in four through their handles
+ * before they reach the top, as a scheduler does with timeouts that never
+ * fire, then pops the rest. `erase()` removes each one in `~log n`, and
+ * `cancel()` just marks it dead.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue, bool Cancel>
+size_t removeMost(const vector<int>& priorities) {
+	size_t n = priorities.size();
+	Queue queue(n);
+	vector<typename Queue::Handle> handles(n);
+	for(size_t i = 0; i < n; i++) {
+		handles[i] = queue.insert(i, priorities[i]);
+	}
+	for(size_t i = 0; i < n; i++) {
+		if(i % 4 != 0) {
+			if(Cancel) {
+				queue.cancel(handles[i]);
+			} else {
+				queue.erase(handles[i]);
+			}
+		}
+	}
+	while(!queue.empty()) {
+		queue.pop();
+	}
+	return n + n - n / 4;
+}
+
+/**
+ * The classic "hold" model: fill to half the priorities, then repeatedly
+ * pop the top and insert a new item whose priority depends on the popped
+ * one, keeping the queue size constant.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t hold(const vector<int>& priorities) {
+	size_t half = priorities.size() / 2;
+	Queue queue(half + 1);
+	for(size_t i = 0; i < half; i++) {
+		queue.insert(i, priorities[i]);
+	}
+	for(size_t i = half; i < priorities.size(); i++) {
+		size_t top = queue.top();
+		queue.pop();
+		queue.insert(top, priorities[i] - (1 << 20));
+	}
+	return 2 * (priorities.size() - half);
+}
+
+/**
+ * Runs `workload` `reps` times and prints the best time per operation.
+ */
+template<size_t (*Workload)(const vector<int>&)>
+void run(const string& workloadName, const string& variantName,
+		 const vector<int>& priorities, int reps) {
+	double bestNanosPerOp = 0;
+	for(int rep = 0; rep < reps; rep++) {
+		steady_clock::time_point start = steady_clock::now();
+		size_t ops = Workload(priorities);
+		duration<double> elapsed = steady_clock::now() - start;
+
+		double nanosPerOp = elapsed.count() * NANOS_PER_SECOND / ops;
+		if(rep == 0 || nanosPerOp < bestNanosPerOp) {
+			bestNanosPerOp = nanosPerOp;
+		}
+	}
+
+	cout << left << setw(12) << workloadName
+		 << setw(20) << variantName
+		 << right << setw(10) << priorities.size()
+		 << setw(12) << fixed << setprecision(1) << bestNanosPerOp
+		 << endl;
+}
+
+/**
+ * Makes a queue for `n` priorities in `[0, SMALL_RANGE)`.
+ */
+template<class Queue>
+Queue* makeSmallRangeQueue(Queue*, size_t n) {
+	return new Queue(n);
+}
+
+BucketQueue<size_t>* makeSmallRangeQueue(BucketQueue<size_t>*, size_t n) {
+	return new BucketQueue<size_t>(0, SMALL_RANGE - 1, n);
+}
+
+/**
+ * The "hold" model with priorities in `[0, SMALL_RANGE)`, as in the
+ * sportsball data.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t smallRangeHold(const vector<int>& priorities) {
+	size_t half = priorities.size() / 2;
+	Queue* queue = makeSmallRangeQueue(static_cast<Queue*>(nullptr), half + 1);
+	for(size_t i = 0; i < half; i++) {
+		queue->insert(i, priorities[i] % SMALL_RANGE);
+	}
+	for(size_t i = half; i < priorities.size(); i++) {
+		size_t top = queue->top();
+		queue->pop();
+		queue->insert(top, priorities[i] % SMALL_RANGE);
+	}
+	delete queue;
+	return 2 * (priorities.size() - half);
+}
+
+/**
+ * Makes a lowest-first queue for `n` monotone keys.
+ */
+template<class Queue>
+Queue* makeMonotoneQueue(Queue*, size_t n) {
+	return new Queue(n);
+}
+
+RadixHeap<size_t>* makeMonotoneQueue(RadixHeap<size_t>*, size_t) {
+	return new RadixHeap<size_t>();
+}
+
+/**
+ * The "hold" model with monotone keys, as in Dijkstra's algorithm or an
+ * event simulation: each inserted key is the popped key plus a small step.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t monotoneHold(const vector<int>& priorities) {
+	size_t half = priorities.size() / 2;
+	Queue* queue = makeMonotoneQueue(static_cast<Queue*>(nullptr), half + 1);
+	for(size_t i = 0; i < half; i++) {
+		queue->insert(i, priorities[i] % SMALL_RANGE);
+	}
+	for(size_t i = half; i < priorities.size(); i++) {
+		size_t top = queue->top();
+		uint32_t key = queue->getTopPriority();
+		queue->pop();
+		queue->insert(top, key + priorities[i] % SMALL_RANGE);
+	}
+	delete queue;
+	return 2 * (priorities.size() - half);
+}
+
+/**
+ * Timers in an addressable `PriorityQueue` keyed by deadline, with the
+ * interface of `TimerScheduler`: the baseline for the timer wheel.
+ */
+class HeapTimers {
+public:
+	typedef steady_clock::time_point TimePoint;
+	typedef PriorityQueue<size_t, TimePoint::rep, std::less<TimePoint::rep>,
+			AddressableLayout<>, 2, GeometricGrowth> Queue;
+	typedef Queue::Handle Handle;
+
+	HeapTimers(steady_clock::duration, TimePoint) {}
+
+	Handle schedule_at(TimePoint deadline, size_t item) {
+		return mQueue.insert(item, deadline.time_since_epoch().count());
+	}
+
+	bool cancel(Handle handle) {
+		// Cancelled timers are scattered through the heap, so most erases
+		// are cheap, and beat `cancel()` here
+		mQueue.erase(handle);
+		return true;
+	}
+
+	template<class Callback>
+	size_t run_due(TimePoint now, Callback callback) {
+		size_t count = 0;
+		while(!mQueue.empty()
+				&& mQueue.getTopPriority() <= now.time_since_epoch().count()) {
+			size_t item = mQueue.pop_value();
+			callback(item);
+			count++;
+		}
+		return count;
+	}
+
+private:
+	Queue mQueue;
+};
+
+/**
+ * A timeout scheduler's day: each tick, schedule a timer up to
+ * `TIMER_SPAN` ticks ahead, cancel three in four timers a while after
+ * scheduling them (as when the guarded operation completes in time), and
+ * run the ones that are due.
+ *
+ * @return the number of timer operations performed
+ */
+template<class Timers>
+size_t timeouts(const vector<int>& priorities) {
+	typedef steady_clock::time_point TimePoint;
+	const steady_clock::duration tick = std::chrono::milliseconds(1);
+	const TimePoint origin;
+	Timers timers(tick, origin);
+
+	size_t n = priorities.size();
+	vector<typename Timers::Handle> handles(n);
+	size_t cancelled = 0;
+	size_t ran = 0;
+	for(size_t i = 0; i < n; i++) {
+		TimePoint now = origin + tick * static_cast<int>(i);
+		handles[i] = timers.schedule_at(
+				now + tick * (priorities[i] % TIMER_SPAN), i);
+		// Three in four timers are cancelled `SMALL_RANGE` ticks later,
+		// unless they ran already
+		if(i >= SMALL_RANGE) {
+			size_t old = i - SMALL_RANGE;
+			if(old % 4 != 0 && priorities[old] % TIMER_SPAN > SMALL_RANGE) {
+				timers.cancel(handles[old]);
+				cancelled++;
+			}
+		}
+		ran += timers.run_due(now, [](size_t&) {});
+	}
+	return n + cancelled + ran;
+}
+
+/**
+ * Makes a default-sized queue, from `arena` if it can use one.
+ */
+template<class Queue>
+Queue* makeSmallQueue(Queue*, memory_resource*) {
+	return new Queue();
+}
+
+template<class T>
+PmrPriorityQueue<T>* makeSmallQueue(PmrPriorityQueue<T>*,
+		memory_resource* arena) {
+	return new PmrPriorityQueue<T>(arena);
+}
+
+/**
+ * Many short-lived queues of `SMALL_QUEUE_SIZE` items, like one per
+ * request. Each starts at the default capacity and grows a few times, so
+ * allocation is a good part of the cost. Queues that can take an arena
+ * share one, released after each queue. (A `StaticPriorityQueue` needs
+ * neither.)
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t smallQueues(const vector<int>& priorities) {
+	static unsigned char buffer[ARENA_SIZE];
+	monotonic_buffer_resource arena(buffer, sizeof(buffer));
+	for(size_t first = 0; first < priorities.size();
+			first += SMALL_QUEUE_SIZE) {
+		size_t last = min(first + SMALL_QUEUE_SIZE, priorities.size());
+		Queue* queue = makeSmallQueue(static_cast<Queue*>(nullptr), &arena);
+		for(size_t i = first; i < last; i++) {
+			queue->insert(i, priorities[i]);
+		}
+		while(!queue->empty()) {
+			queue->pop();
+		}
+		delete queue;
+		arena.release();
+	}
+	return 2 * priorities.size();
+}
+
+/**
+ * Keeps the best `TOP_K` items by inserting every one and popping the top.
+ */
+template<class Queue>
+void keepBest(Queue*, const vector<int>& priorities, vector<size_t>& best) {
+	Queue queue;
+	for(size_t i = 0; i < priorities.size(); i++) {
+		queue.insert(i, priorities[i]);
+	}
+	queue.pop_n(TOP_K, back_inserter(best));
+}
+
+/**
+ * Keeps the best `TOP_K` items in a queue bounded to that many.
+ */
+template<class T>
+void keepBest(BoundedPriorityQueue<T>*, const vector<int>& priorities,
+		vector<size_t>& best) {
+	BoundedPriorityQueue<T> queue(TOP_K);
+	for(size_t i = 0; i < priorities.size(); i++) {
+		queue.insert(i, priorities[i]);
+	}
+	queue.drain(back_inserter(best));
+}
+
+/**
+ * Streams every priority through the queue, keeping the best `TOP_K`.
+ *
+ * @return the number of items offered
+ */
+template<class Queue>
+size_t topK(const vector<int>& priorities) {
+	vector<size_t> best;
+	best.reserve(TOP_K);
+	keepBest(static_cast<Queue*>(nullptr), priorities, best);
+	return priorities.size();
+}
+
+/**
+ * Deals the priorities out to `NUM_SOURCES` queues, like one per worker.
+ */
+template<class Queue>
+void fillSources(const vector<int>& priorities, vector<Queue>& sources) {
+	for(size_t i = 0; i < priorities.size(); i++) {
+		sources[i % NUM_SOURCES].insert(i, priorities[i]);
+	}
+}
+
+/**
+ * Combines per-worker queues by popping each into the first.
+ *
+ * @return the number of items combined
+ */
+template<class Queue>
+size_t popMerge(const vector<int>& priorities) {
+	vector<Queue> sources(NUM_SOURCES);
+	fillSources(priorities, sources);
+	for(size_t s = 1; s < NUM_SOURCES; s++) {
+		while(!sources[s].empty()) {
+			int score = sources[s].getTopPriority();
+			sources[0].insert(sources[s].pop_value(), score);
+		}
+	}
+	return priorities.size();
+}
+
+/**
+ * Combines per-worker queues with `merge()`.
+ *
+ * @return the number of items combined
+ */
+template<class Queue>
+size_t bulkMerge(const vector<int>& priorities) {
+	vector<Queue> sources(NUM_SOURCES);
+	fillSources(priorities, sources);
+	for(size_t s = 1; s < NUM_SOURCES; s++) {
+		sources[0].merge(move(sources[s]));
+	}
+	return priorities.size();
+}
+
+/**
+ * A `PriorityQueue` behind one mutex: the baseline for `MultiQueue`.
+ */
+class LockedQueue {
+public:
+	LockedQueue(size_t initialCapacity) : mQueue(initialCapacity) {}
+
+	void insert(size_t item, int score) {
+		lock_guard<mutex> lock(mLock);
+		mQueue.insert(item, score);
+	}
+
+	bool try_pop(size_t& item) {
+		lock_guard<mutex> lock(mLock);
+		if(mQueue.empty()) {
+			return false;
+		}
+		item = mQueue.pop_value();
+		return true;
+	}
+
+private:
+	mutex mLock;
+	PriorityQueue<size_t> mQueue;
+};
+
+/**
+ * Makes a `LockedQueue` for `threads` threads.
+ */
+LockedQueue* makeQueue(LockedQueue*, size_t n, size_t) {
+	return new LockedQueue(n);
+}
+
+/**
+ * Makes a `MultiQueue` with two shards per thread.
+ */
+MultiQueue<size_t>* makeQueue(MultiQueue<size_t>*, size_t n, size_t threads) {
+	size_t numShards = MultiQueue<size_t>::DEFAULT_SHARDS_PER_THREAD * threads;
+	return new MultiQueue<size_t>(numShards, n / numShards + 1);
+}
+
+/**
+ * The "hold" model on `threads` threads sharing one queue: fill to half the
+ * priorities, then have each thread pop an item and insert a new one, over
+ * its share of the other half.
+ *
+ * @return the number of queue operations performed
+ */
+template<class Queue>
+size_t concurrentHold(const vector<int>& priorities, size_t threads) {
+	size_t half = priorities.size() / 2;
+	Queue* queue = makeQueue(static_cast<Queue*>(nullptr), half + 1, threads);
+	for(size_t i = 0; i < half; i++) {
+		queue->insert(i, priorities[i]);
+	}
+
+	vector<thread> workers;
+	size_t perThread = (priorities.size() - half) / threads;
+	for(size_t t = 0; t < threads; t++) {
+		size_t begin = half + t * perThread;
+		workers.push_back(thread([queue, &priorities, begin, perThread]() {
+			size_t top;
+			for(size_t i = begin; i < begin + perThread; i++) {
+				if(queue->try_pop(top)) {
+					queue->insert(top, priorities[i] - (1 << 20));
+				}
+			}
+		}));
+	}
+	for(size_t t = 0; t < threads; t++) {
+		workers[t].join();
+	}
+
+	delete queue;
+	return 2 * perThread * threads;
+}
+
+typedef BlockingPriorityQueue<size_t> WorkQueue;
+
+/**
+ * Pushes this producer's share of the priorities, one item at a time or
+ * `BATCH_SIZE` at a time.
+ */
+void produce(WorkQueue* queue, const vector<int>& priorities, size_t begin,
+		size_t end, bool batched) {
+	if(!batched) {
+		for(size_t i = begin; i < end; i++) {
+			queue->push(i, priorities[i]);
+		}
+		return;
+	}
+	vector<pair<size_t, int> > batch;
+	batch.reserve(BATCH_SIZE);
+	for(size_t i = begin; i < end; i += BATCH_SIZE) {
+		batch.clear();
+		for(size_t j = i; j < min(i + BATCH_SIZE, end); j++) {
+			batch.push_back(pair<size_t, int>(j, priorities[j]));
+		}
+		queue->push_range(batch.begin(), batch.end());
+	}
+}
+
+/**
+ * Pops until the queue is closed and empty, one item at a time or up to
+ * `BATCH_SIZE` at a time.
+ */
+void consume(WorkQueue* queue, bool batched) {
+	if(!batched) {
+		size_t item;
+		while(queue->pop_wait(item)) {}
+		return;
+	}
+	vector<size_t> batch(BATCH_SIZE);
+	while(queue->pop_n_wait(BATCH_SIZE, batch.begin()) > 0) {}
+}
+
+/**
+ * Half the threads (at least one) push every priority through a bounded
+ * `BlockingPriorityQueue` to the other half, which pop until it's closed.
+ *
+ * @return the number of queue operations performed
+ */
+template<bool Batched>
+size_t producerConsumer(const vector<int>& priorities, size_t threads) {
+	size_t producers = (threads > 1) ? threads / 2 : 1;
+	size_t consumers = (threads > producers) ? threads - producers : 1;
+	WorkQueue queue(WORK_QUEUE_BOUND);
+
+	vector<thread> workers;
+	size_t perProducer = priorities.size() / producers;
+	for(size_t t = 0; t < producers; t++) {
+		size_t begin = t * perProducer;
+		workers.push_back(thread(produce, &queue, std::cref(priorities),
+				begin, begin + perProducer, Batched));
+	}
+	vector<thread> sinks;
+	for(size_t t = 0; t < consumers; t++) {
+		sinks.push_back(thread(consume, &queue, Batched));
+	}
+	for(size_t t = 0; t < producers; t++) {
+		workers[t].join();
+	}
+	queue.close();
+	for(size_t t = 0; t < consumers; t++) {
+		sinks[t].join();
+	}
+	return 2 * perProducer * producers;
+}
+
+/**
+ * Runs a multi-threaded `Workload` on 1, 2, 4, ... up to `maxThreads`
+ * threads, `reps` times each, and prints the best wall-clock time per
+ * operation.
+ */
+template<size_t (*Workload)(const vector<int>&, size_t)>
+void runScaling(const string& workloadName, const string& variantName,
+				const vector<int>& priorities, int reps, size_t maxThreads) {
+	for(size_t threads = 1; threads <= maxThreads; threads *= 2) {
+		double bestNanosPerOp = 0;
+		for(int rep = 0; rep < reps; rep++) {
+			steady_clock::time_point start = steady_clock::now();
+			size_t ops = Workload(priorities, threads);
+			duration<double> elapsed = steady_clock::now() - start;
+
+			double nanosPerOp = elapsed.count() * NANOS_PER_SECOND / ops;
+			if(rep == 0 || nanosPerOp < bestNanosPerOp) {
+				bestNanosPerOp = nanosPerOp;
+			}
+		}
+
+		cout << left << setw(12) << workloadName
+			 << setw(20) << (variantName + "/" + std::to_string(threads))
+			 << right << setw(10) << priorities.size()
+			 << setw(12) << fixed << setprecision(1) << bestNanosPerOp
+			 << endl;
+	}
+}
+
+//------------------------------------------------------------------------------
+// AGAINST std::priority_queue
+//------------------------------------------------------------------------------
+
+/**
+ * An item of `Bytes` bytes, to see how payload size affects each queue.
+ */
+template<size_t Bytes>
+struct PaddedItem {
+	PaddedItem(size_t id=0) : mId(id) {}
+
+	size_t mId;
+	unsigned char mPadding[Bytes - sizeof(size_t)];
+};
+
+// An item of `Bytes` bytes: a plain `size_t`, or padded up to `Bytes`
+template<size_t Bytes>
+using Item = typename conditional<Bytes == sizeof(size_t), size_t,
+		PaddedItem<Bytes> >::type;
+
+/**
+ * `std::priority_queue` behind the interface of `PriorityQueue`, as the
+ * baseline. Like `UnstableLayout`, it leaves ties in no particular order.
+ */
+template<class T>
+class StdQueue {
+public:
+	explicit StdQueue(size_t initialCapacity) {
+		vector<Entry> entries;
+		entries.reserve(initialCapacity);
+		mQueue = Queue(EntryLess(), std::move(entries));
+	}
+
+	void insert(const T& item, int priority) {
+		mQueue.push(Entry { priority, item });
+	}
+
+	const T& top() const {
+		return mQueue.top().mItem;
+	}
+
+	void pop() {
+		mQueue.pop();
+	}
+
+	bool empty() const {
+		return mQueue.empty();
+	}
+
+private:
+	struct Entry {
+		int mPriority;
+		T mItem;
+	};
+
+	struct EntryLess {
+		bool operator()(const Entry& a, const Entry& b) const {
+			return a.mPriority < b.mPriority;
+		}
+	};
+
+	typedef priority_queue<Entry, vector<Entry>, EntryLess> Queue;
+	Queue mQueue;
+};
+
+/**
+ * Times a workload in laps of `LAP_OPS` operations.
+ *
+ * Reading the clock costs more than most queue operations, so operations
+ * aren't timed one by one: each lap gives the mean time per operation over
+ * its `LAP_OPS`, and the percentiles are taken over the laps.
+ */
+class Laps {
+public:
+	Laps() : mOps(0), mTotalOps(0) {}
+
+	/**
+	 * Starts the clock, after any untimed setup.
+	 */
+	void start() {
+		mStart = mLapStart = steady_clock::now();
+	}
+
+	/**
+	 * Counts an operation, ending the lap after every `LAP_OPS`.
+	 */
+	void op() {
+		if(++mOps == LAP_OPS) {
+			endLap();
+		}
+	}
+
+	/**
+	 * Stops the clock, ending the last lap.
+	 */
+	void stop() {
+		if(mOps > 0) {
+			endLap();
+		}
+		mElapsed = mLapStart - mStart;
+	}
+
+	/**
+	 * Returns the time per operation, in nanoseconds, that `fraction` of
+	 * the laps came in under.
+	 */
+	double percentile(double fraction) {
+		if(mNanosPerOp.empty()) {
+			return 0;
+		}
+		if(!std::is_sorted(mNanosPerOp.begin(), mNanosPerOp.end())) {
+			sort(mNanosPerOp.begin(), mNanosPerOp.end());
+		}
+		size_t rank = static_cast<size_t>(fraction * mNanosPerOp.size());
+		return mNanosPerOp[min(rank, mNanosPerOp.size() - 1)];
+	}
+
+	/**
+	 * Returns the operations per second over the whole run.
+	 */
+	double throughput() const {
+		return mTotalOps / duration<double>(mElapsed).count();
+	}
+
+	steady_clock::duration getElapsed() const {
+		return mElapsed;
+	}
+
+private:
+	size_t mOps; // in this lap
+	size_t mTotalOps;
+	steady_clock::time_point mStart;
+	steady_clock::time_point mLapStart;
+	steady_clock::duration mElapsed;
+	vector<double> mNanosPerOp; // one per lap
+
+	void endLap() {
+		steady_clock::time_point now = steady_clock::now();
+		duration<double, std::nano> lap = now - mLapStart;
+		mNanosPerOp.push_back(lap.count() / mOps);
+		mTotalOps += mOps;
+		mOps = 0;
+		mLapStart = now;
+	}
+};
+
+/**
+ * Returns the `n` priorities of `randomPriorities()`, sorted ascending (so
+ * each insert rises to the top of a max-queue) or descending (so none
+ * rises at all).
+ */
+vector<int> sortedPriorities(size_t n, bool ascending) {
+	vector<int> priorities = randomPriorities(n);
+	if(ascending) {
+		sort(priorities.begin(), priorities.end());
+	} else {
+		sort(priorities.begin(), priorities.end(), std::greater<int>());
+	}
+	return priorities;
+}
+
+/**
+ * Returns `n` pseudo-random priorities in `[0, DUPLICATE_RANGE)`, so most
+ * of them are ties.
+ */
+vector<int> duplicatePriorities(size_t n) {
+	vector<int> priorities = randomPriorities(n);
+	for(int& priority : priorities) {
+		priority %= DUPLICATE_RANGE;
+	}
+	return priorities;
+}
+
+/**
+ * Inserts every priority, popping once after every third insert.
+ */
+template<class Queue, class T>
+void insertHeavy(const vector<int>& priorities, Laps& laps) {
+	Queue queue(priorities.size());
+	laps.start();
+	for(size_t i = 0; i < priorities.size(); i++) {
+		queue.insert(T(i), priorities[i]);
+		laps.op();
+		if(i % 3 == 2) {
+			queue.pop();
+			laps.op();
+		}
+	}
+	laps.stop();
+}
+
+/**
+ * Pops a queue holding every priority until it's empty. The queue is
+ * filled before the clock starts.
+ */
+template<class Queue, class T>
+void popHeavy(const vector<int>& priorities, Laps& laps) {
+	Queue queue(priorities.size());
+	for(size_t i = 0; i < priorities.size(); i++) {
+		queue.insert(T(i), priorities[i]);
+	}
+	laps.start();
+	while(!queue.empty()) {
+		queue.pop();
+		laps.op();
+	}
+	laps.stop();
+}
+
+/**
+ * Alternates inserting the second half of the priorities with popping,
+ * starting from a queue holding the first half. Unlike `hold`, the new
+ * priorities don't depend on the popped ones.
+ */
+template<class Queue, class T>
+void alternating(const vector<int>& priorities, Laps& laps) {
+	size_t half = priorities.size() / 2;
+	Queue queue(half + 1);
+	for(size_t i = 0; i < half; i++) {
+		queue.insert(T(i), priorities[i]);
+	}
+	laps.start();
+	for(size_t i = half; i < priorities.size(); i++) {
+		queue.insert(T(i), priorities[i]);
+		laps.op();
+		queue.pop();
+		laps.op();
+	}
+	laps.stop();
+}
+
+/**
+ * The hold model of `hold()`, with the queue filled before the clock
+ * starts and the popped item reinserted.
+ */
+template<class Queue, class T>
+void holdModel(const vector<int>& priorities, Laps& laps) {
+	size_t half = priorities.size() / 2;
+	Queue queue(half + 1);
+	for(size_t i = 0; i < half; i++) {
+		queue.insert(T(i), priorities[i]);
+	}
+	laps.start();
+	for(size_t i = half; i < priorities.size(); i++) {
+		T top = queue.top();
+		queue.pop();
+		laps.op();
+		queue.insert(top, priorities[i] - (1 << 20));
+		laps.op();
+	}
+	laps.stop();
+}
+
+/**
+ * Inserts every priority, then pops until empty, as `fillDrain()`.
+ */
+template<class Queue, class T>
+void fillDrainLaps(const vector<int>& priorities, Laps& laps) {
+	Queue queue(priorities.size());
+	laps.start();
+	for(size_t i = 0; i < priorities.size(); i++) {
+		queue.insert(T(i), priorities[i]);
+		laps.op();
+	}
+	while(!queue.empty()) {
+		queue.pop();
+		laps.op();
+	}
+	laps.stop();
+}
+
+/**
+ * Resets the peak resident set size the kernel keeps for this process, so
+ * the next `readRss("VmHWM")` only covers what runs in between.
+ *
+ * Memory freed by earlier runs is handed back to the system first, or
+ * later runs would reuse it without adding to the peak.
+ *
+ * @return false if that isn't supported (on anything but Linux)
+ */
+bool resetPeakRss() {
+	malloc_trim(0);
+	ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+	clearRefs.close();
+	return !clearRefs.fail();
+}
+
+/**
+ * Returns the `field` (`VmRSS` or `VmHWM`) of `/proc/self/status`, in
+ * bytes, or 0 if it can't be read.
+ */
+size_t readRss(const string& field) {
+	ifstream status("/proc/self/status");
+	string line;
+	while(std::getline(status, line)) {
+		if(line.compare(0, field.size() + 1, field + ":") == 0) {
+			return std::stoul(line.substr(field.size() + 1)) * 1024;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Runs `workload` `reps` times and prints, for the fastest run, the
+ * throughput and percentiles of the time per operation, then the most
+ * memory resident at once across all runs beyond what was resident
+ * before.
+ */
+template<void (*Workload)(const vector<int>&, Laps&)>
+void runLaps(const string& workloadName, const string& inputName,
+			 size_t itemBytes, const string& variantName,
+			 const vector<int>& priorities, int reps) {
+	bool trackRss = resetPeakRss();
+	size_t rssBefore = readRss("VmRSS");
+
+	Laps best;
+	for(int rep = 0; rep < reps; rep++) {
+		Laps laps;
+		Workload(priorities, laps);
+		if(rep == 0 || laps.getElapsed() < best.getElapsed()) {
+			best = std::move(laps);
+		}
+	}
+
+	size_t peakRss = readRss("VmHWM");
+	cout << left << setw(14) << workloadName
+		 << setw(12) << inputName
+		 << right << setw(6) << itemBytes << "  "
+		 << left << setw(16) << variantName
+		 << right << setw(10) << priorities.size()
+		 << fixed << setprecision(2)
+		 << setw(10) << best.throughput() / 1e6
+		 << setprecision(1)
+		 << setw(9) << best.percentile(0.5)
+		 << setw(9) << best.percentile(0.9)
+		 << setw(9) << best.percentile(0.99)
+		 << setw(9) << best.percentile(0.999);
+	if(trackRss && peakRss >= rssBefore) {
+		cout << setw(10) << (peakRss - rssBefore) / BYTES_PER_MB;
+	} else {
+		cout << setw(10) << "-";
+	}
+	cout << endl;
+}
+
+/**
+ * Runs each workload and input on items of `Bytes` bytes in a
+ * `std::priority_queue`, in the default `PriorityQueue` and in the fastest
+ * unstable one.
+ */
+template<size_t Bytes>
+void compareWithStd(const vector<int>& random, const vector<int>& ascending,
+					const vector<int>& descending,
+					const vector<int>& duplicates, int reps) {
+	typedef Item<Bytes> T;
+	typedef StdQueue<T> Std;
+	typedef PriorityQueue<T> Triad;
+	typedef PriorityQueue<T, int, std::greater<int>, UnstableLayout, 4>
+		Unstable4;
+
+	runLaps<insertHeavy<Std, T> >("insert-heavy", "random", Bytes, "std",
+			random, reps);
+	runLaps<insertHeavy<Triad, T> >("insert-heavy", "random", Bytes, "triad",
+			random, reps);
+	runLaps<insertHeavy<Unstable4, T> >("insert-heavy", "random", Bytes,
+			"unstable/4-ary", random, reps);
+	runLaps<popHeavy<Std, T> >("pop-heavy", "random", Bytes, "std", random,
+			reps);
+	runLaps<popHeavy<Triad, T> >("pop-heavy", "random", Bytes, "triad",
+			random, reps);
+	runLaps<popHeavy<Unstable4, T> >("pop-heavy", "random", Bytes,
+			"unstable/4-ary", random, reps);
+	runLaps<alternating<Std, T> >("alternating", "random", Bytes, "std",
+			random, reps);
+	runLaps<alternating<Triad, T> >("alternating", "random", Bytes, "triad",
+			random, reps);
+	runLaps<alternating<Unstable4, T> >("alternating", "random", Bytes,
+			"unstable/4-ary", random, reps);
+	runLaps<holdModel<Std, T> >("hold", "random", Bytes, "std", random, reps);
+	runLaps<holdModel<Triad, T> >("hold", "random", Bytes, "triad", random,
+			reps);
+	runLaps<holdModel<Unstable4, T> >("hold", "random", Bytes,
+			"unstable/4-ary", random, reps);
+	runLaps<fillDrainLaps<Std, T> >("fill-drain", "ascending", Bytes, "std",
+			ascending, reps);
+	runLaps<fillDrainLaps<Triad, T> >("fill-drain", "ascending", Bytes,
+			"triad", ascending, reps);
+	runLaps<fillDrainLaps<Unstable4, T> >("fill-drain", "ascending", Bytes,
+			"unstable/4-ary", ascending, reps);
+	runLaps<fillDrainLaps<Std, T> >("fill-drain", "descending", Bytes, "std",
+			descending, reps);
+	runLaps<fillDrainLaps<Triad, T> >("fill-drain", "descending", Bytes,
+			"triad", descending, reps);
+	runLaps<fillDrainLaps<Unstable4, T> >("fill-drain", "descending", Bytes,
+			"unstable/4-ary", descending, reps);
+	runLaps<fillDrainLaps<Std, T> >("fill-drain", "duplicates", Bytes, "std",
+			duplicates, reps);
+	runLaps<fillDrainLaps<Triad, T> >("fill-drain", "duplicates", Bytes,
+			"triad", duplicates, reps);
+	runLaps<fillDrainLaps<Unstable4, T> >("fill-drain", "duplicates", Bytes,
+			"unstable/4-ary", duplicates, reps);
+}
+
+/**
+ * Runs every workload against `std::priority_queue`, on items of 8, 64 and
+ * 256 bytes.
+ */
+void runVsStd(size_t n, int reps) {
+	vector<int> random = randomPriorities(n);
+	vector<int> ascending = sortedPriorities(n, true);
+	vector<int> descending = sortedPriorities(n, false);
+	vector<int> duplicates = duplicatePriorities(n);
+
+	cout << left << setw(14) << "workload"
+		 << setw(12) << "input"
+		 << right << setw(6) << "bytes" << "  "
+		 << left << setw(16) << "variant"
+		 << right << setw(10) << "n"
+		 << setw(10) << "Mops/s"
+		 << setw(9) << "p50"
+		 << setw(9) << "p90"
+		 << setw(9) << "p99"
+		 << setw(9) << "p99.9"
+		 << setw(10) << "peak MB" << endl;
+
+	compareWithStd<8>(random, ascending, descending, duplicates, reps);
+	compareWithStd<64>(random, ascending, descending, duplicates, reps);
+	compareWithStd<256>(random, ascending, descending, duplicates, reps);
+}
+
+//------------------------------------------------------------------------------
+// VARIANTS
+//------------------------------------------------------------------------------
+
+/**
+ * Runs every workload against every variant of `PriorityQueue`.
+ *
+ * Built with `-mavx2` (as `pq_bench_avx2`), the 4- and 8-ary variants
+ * select children with vector instructions; compare the two builds to see
+ * the effect.
+ */
+void runAll(size_t n, int reps, size_t maxThreads) {
+	typedef std::greater<int> Greater;
+	typedef PriorityQueue<size_t, int, Greater, TriadLayout, 2> TriadQueue;
+	typedef PriorityQueue<size_t, int, Greater, TriadLayout, 4> Triad4Queue;
+	typedef PriorityQueue<size_t, int, Greater, CompactTriadLayout, 4>
+		Compact4Queue;
+	typedef PriorityQueue<size_t, int, Greater, TriadLayout, 2,
+			GeometricGrowth> GeometricQueue;
+	typedef PriorityQueue<size_t, int, Greater, UnstableLayout, 4>
+		Unstable4Queue;
+	typedef PriorityQueue<size_t, int, Greater, FusedKeyLayout, 2> FusedQueue;
+	typedef PriorityQueue<size_t, int, Greater, FusedKeyLayout, 4> Fused4Queue;
+	typedef PriorityQueue<size_t, int, Greater, FusedKeyLayout, 8> Fused8Queue;
+	typedef PriorityQueue<size_t, int, Greater, TriadLayout, 8> Triad8Queue;
+	typedef std::less<uint32_t> Less;
+	typedef PriorityQueue<size_t, uint32_t, Less, TriadLayout, 2> MinQueue;
+	typedef PriorityQueue<size_t, uint32_t, Less, FusedKeyLayout, 4>
+		MinFused4Queue;
+	typedef PriorityQueue<size_t, int, Greater, AddressableLayout<>, 2>
+		AddressableQueue;
+	typedef PriorityQueue<size_t, int, Greater,
+			AddressableLayout<FusedKeyLayout>, 4> AddressableFused4Queue;
+
+	vector<int> priorities = randomPriorities(n);
+
+	cout << left << setw(12) << "workload"
+		 << setw(20) << "variant"
+		 << right << setw(10) << "n"
+		 << setw(12) << "ns/op" << endl;
+
+	run<fillDrain<TriadQueue> >("fill-drain", "triad", priorities, reps);
+	run<fillDrain<Triad4Queue> >("fill-drain", "triad/4-ary", priorities, reps);
+	run<fillDrain<Compact4Queue> >("fill-drain", "compact/4-ary", priorities,
+			reps);
+	run<fillDrain<Unstable4Queue> >("fill-drain", "unstable/4-ary",
+			priorities, reps);
+	run<fillDrain<FusedQueue> >("fill-drain", "fused", priorities, reps);
+	run<fillDrain<Fused4Queue> >("fill-drain", "fused/4-ary", priorities, reps);
+	run<fillDrain<Fused8Queue> >("fill-drain", "fused/8-ary", priorities, reps);
+	run<bulkDrain<TriadQueue> >("bulk-drain", "triad", priorities, reps);
+	run<bulkDrain<Triad4Queue> >("bulk-drain", "triad/4-ary", priorities, reps);
+	run<bulkDrain<Triad8Queue> >("bulk-drain", "triad/8-ary", priorities, reps);
+	run<bulkDrain<Unstable4Queue> >("bulk-drain", "unstable/4-ary",
+			priorities, reps);
+	run<bulkDrain<Fused4Queue> >("bulk-drain", "fused/4-ary", priorities, reps);
+	run<bulkDrain<Fused8Queue> >("bulk-drain", "fused/8-ary", priorities, reps);
+	run<batchDrain<TriadQueue> >("batch-drain", "triad", priorities, reps);
+	run<batchDrain<Fused4Queue> >("batch-drain", "fused/4-ary", priorities,
+			reps);
+	run<fullDrain<TriadQueue> >("drain", "triad", priorities, reps);
+	run<fullDrain<Fused4Queue> >("drain", "fused/4-ary", priorities, reps);
+	run<fillDrain<AddressableQueue> >("fill-drain", "addressable", priorities,
+			reps);
+	run<raiseKey<AddressableQueue> >("raise-key", "addressable", priorities,
+			reps);
+	run<raiseKey<AddressableFused4Queue> >("raise-key",
+			"addressable/fused/4", priorities, reps);
+	run<removeMost<AddressableQueue, false> >("remove-most", "erase",
+			priorities, reps);
+	run<removeMost<AddressableQueue, true> >("remove-most", "cancel",
+			priorities, reps);
+	run<hold<TriadQueue> >("hold", "triad", priorities, reps);
+	run<hold<Triad4Queue> >("hold", "triad/4-ary", priorities, reps);
+	run<hold<Compact4Queue> >("hold", "compact/4-ary", priorities, reps);
+	run<hold<Unstable4Queue> >("hold", "unstable/4-ary", priorities, reps);
+	run<hold<FusedQueue> >("hold", "fused", priorities, reps);
+	run<hold<Fused4Queue> >("hold", "fused/4-ary", priorities, reps);
+	run<hold<Fused8Queue> >("hold", "fused/8-ary", priorities, reps);
+	run<smallRangeHold<TriadQueue> >("small-hold", "triad", priorities, reps);
+	run<smallRangeHold<Fused4Queue> >("small-hold", "fused/4-ary", priorities,
+			reps);
+	run<smallRangeHold<BucketQueue<size_t> > >("small-hold", "bucket",
+			priorities, reps);
+	run<monotoneHold<MinQueue> >("mono-hold", "triad", priorities, reps);
+	run<monotoneHold<MinFused4Queue> >("mono-hold", "fused/4-ary", priorities,
+			reps);
+	run<monotoneHold<RadixHeap<size_t> > >("mono-hold", "radix", priorities,
+			reps);
+	run<smallQueues<TriadQueue> >("many-queues", "triad", priorities, reps);
+	run<smallQueues<PmrPriorityQueue<size_t> > >("many-queues",
+			"triad/arena", priorities, reps);
+	run<smallQueues<StaticPriorityQueue<size_t, SMALL_QUEUE_SIZE> > >(
+			"many-queues", "static", priorities, reps);
+	run<topK<GeometricQueue> >("top-k", "triad/geometric", priorities, reps);
+	run<topK<BoundedPriorityQueue<size_t> > >("top-k", "bounded", priorities,
+			reps);
+	run<popMerge<GeometricQueue> >("merge", "pop-insert", priorities, reps);
+	run<bulkMerge<GeometricQueue> >("merge", "merge", priorities, reps);
+	run<timeouts<HeapTimers> >("timeouts", "heap", priorities, reps);
+	run<timeouts<TimerScheduler<size_t> > >("timeouts", "wheel", priorities,
+			reps);
+	runScaling<concurrentHold<LockedQueue> >("mt-hold", "locked", priorities,
+			reps, maxThreads);
+	runScaling<concurrentHold<MultiQueue<size_t> > >("mt-hold", "multiqueue",
+			priorities, reps, maxThreads);
+	runScaling<producerConsumer<false> >("prod-cons", "blocking", priorities,
+			reps, maxThreads);
+	runScaling<producerConsumer<true> >("prod-cons", "blocking/batch",
+			priorities, reps, maxThreads);
+}
+
+} /* End namespace bench */
+
+/**
+ * Global, main entry-point.
+ *
+ * Usage: pq_bench [--std | --variants] [n] [reps] [threads]
+ *
+ * By default, both suites run: the variants of `PriorityQueue` against each
+ * other, then against `std::priority_queue`. `--std` or `--variants` runs
+ * just one. The multi-threaded workloads run on up to `threads` threads (by
+ * default, one per hardware thread).
+ */
+int main(int argc, const char* argv[]) {
+	const string usage = string("Usage: ") + argv[0]
+			+ " [--std | --variants] [n] [reps] [threads]";
+	bool variants = true;
+	bool vsStd = true;
+	if(argc >= 2 && string(argv[1]) == "--std") {
+		variants = false;
+	} else if(argc >= 2 && string(argv[1]) == "--variants") {
+		vsStd = false;
+	}
+	if(!variants || !vsStd) {
+		// Drop the flag
+		argc--;
+		argv++;
+	}
+
+	size_t n = bench::DEFAULT_N;
+	int reps = bench::DEFAULT_REPS;
+	size_t maxThreads = std::thread::hardware_concurrency();
+	if(maxThreads == 0) {
+		maxThreads = 1;
+	}
+
+	try {
+		if(argc >= 2) {
+			n = std::stoul(argv[1]);
+		}
+		if(argc >= 3) {
+			reps = std::stoi(argv[2]);
+		}
+		if(argc >= 4) {
+			maxThreads = std::stoul(argv[3]);
+		}
+	} catch(invalid_argument& e) {
+		cout << usage << endl;
+		return 1;
+	} catch(out_of_range& e) {
+		cout << usage << endl;
+		return 1;
+	}
+
+	if(variants) {
+		bench::runAll(n, reps, maxThreads);
+	}
+	if(variants && vsStd) {
+		cout << endl;
+	}
+	if(vsStd) {
+		bench::runVsStd(n, reps);
+	}
+	return 0;
+}
@@ -0,0 +1,375 @@
+/*
+ * BlockingPriorityQueue.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef BLOCKINGPRIORITYQUEUE_H_
+#define BLOCKINGPRIORITYQUEUE_H_
+
+#include <mutex>
+using std::mutex;
+using std::unique_lock;
+#include <condition_variable>
+using std::condition_variable;
+#include <chrono>
+#include <limits>
+using std::numeric_limits;
+#include <stdexcept>
+using std::out_of_range;
+#include <utility>
+using std::move;
+
+#include "PriorityQueue.hpp"
+
+/**
+ * A `PriorityQueue` shared by producer and consumer threads, as a work
+ * queue.
+ *
+ * Consumers take items in priority order, waiting while the queue is empty
+ * (`pop_wait()`), for at most some time (`pop_for()`), or not at all
+ * (`try_pop()`). With a bound, producers wait while the queue is full, so
+ * fast producers can't run away from slow consumers. `close()` shuts the
+ * queue down: pushes fail from then on, and pops fail once the items left
+ * are gone, so every waiting thread returns.
+ *
+ * Everything happens under one lock, so the order is exact (unlike
+ * `MultiQueue`'s). To spend less time fighting over that lock, push and pop
+ * in batches: `push_range()` and `pop_n_wait()` move many items per lock
+ * acquisition. Waiting threads are only notified when there's something for
+ * them, and only as many as can use it: a push with no consumer waiting
+ * doesn't touch the condition variable at all.
+ *
+ * The remaining template parameters configure the underlying queue (see
+ * `PriorityQueue`). Handles aren't supported.
+ *
+ * All methods may be called concurrently, except construction and
+ * destruction.
+ */
+template<class T, class Priority=int,
+		 class Compare=std::greater<Priority>,
+		 class KeyLayout=TriadLayout, size_t Arity=2,
+		 class GrowthPolicy=LinearGrowth>
+class BlockingPriorityQueue : DynamicCollectionBase {
+public:
+	typedef PriorityQueue<T, Priority, Compare, KeyLayout, Arity, GrowthPolicy>
+		Queue;
+
+	// The bound of a queue that never blocks producers
+	static const size_t UNBOUNDED = numeric_limits<size_t>::max();
+
+	/**
+	 * Constructs a BlockingPriorityQueue.
+	 *
+	 * @param bound - the most items the queue holds before `push()` waits.
+	 * @param initialCapacity - starting size of the backing data structure.
+	 * @param growthPolicy - decides how the backing data structure grows
+	 *                       when full and shrinks when sparse.
+	 * @throws out_of_range if `bound` is 0
+	 */
+	explicit BlockingPriorityQueue(size_t bound=UNBOUNDED,
+			size_t initialCapacity=DEFAULT_INITIAL_CAPACITY,
+			GrowthPolicy growthPolicy=GrowthPolicy())
+		: mQueue(initialCapacity, growthPolicy),
+		  mBound(bound),
+		  mClosed(false),
+		  mWaitingPops(0),
+		  mWaitingPushes(0)
+	{
+		if(bound == 0) {
+			throw out_of_range("A BlockingPriorityQueue needs room for an item.");
+		}
+	}
+
+	BlockingPriorityQueue(const BlockingPriorityQueue&) = delete;
+	BlockingPriorityQueue& operator=(const BlockingPriorityQueue&) = delete;
+
+	/**
+	 * Inserts `item` with priority `score`, waiting for room if the queue
+	 * is full.
+	 *
+	 * @param item - the item to insert (copied)
+	 * @param score - the priority of this item
+	 * @return false if the queue is closed, leaving `item` alone
+	 */
+	bool push(const T& item, const Priority& score) {
+		unique_lock<mutex> lock(mLock);
+		if(!waitForRoom(lock)) {
+			return false;
+		}
+		mQueue.insert(item, score);
+		wakePops(1);
+		return true;
+	}
+
+	/**
+	 * Inserts `item` with priority `score`, moving from `item`, waiting for
+	 * room if the queue is full.
+	 *
+	 * @param item - the item to insert (moved)
+	 * @param score - the priority of this item
+	 * @return false if the queue is closed, leaving `item` alone
+	 */
+	bool push(T&& item, const Priority& score) {
+		unique_lock<mutex> lock(mLock);
+		if(!waitForRoom(lock)) {
+			return false;
+		}
+		mQueue.insert(move(item), score);
+		wakePops(1);
+		return true;
+	}
+
+	/**
+	 * Inserts `item` with priority `score` if there's room right now.
+	 *
+	 * @param item - the item to insert (copied)
+	 * @param score - the priority of this item
+	 * @return false if the queue is full or closed
+	 */
+	bool try_push(const T& item, const Priority& score) {
+		unique_lock<mutex> lock(mLock);
+		if(mClosed || mQueue.getSize() >= mBound) {
+			return false;
+		}
+		mQueue.insert(item, score);
+		wakePops(1);
+		return true;
+	}
+
+	/**
+	 * Inserts the entries in `[first, last)` under one lock acquisition,
+	 * waiting for room as needed.
+	 *
+	 * Each entry is a `std::pair` (or `std::tuple`) of an item and its
+	 * priority, as for `PriorityQueue::insert_range()`. Without a bound, the
+	 * whole range goes in at once, in `~n` rather than `~n log n`. With one,
+	 * entries go in as room frees up; consumers are woken for each batch
+	 * before waiting for more room.
+	 *
+	 * @param first, last - the range of entries to insert
+	 * @return the number of entries inserted: all of them, unless the queue
+	 *         is (or gets) closed
+	 */
+	template<class InputIt>
+	size_t push_range(InputIt first, InputIt last) {
+		unique_lock<mutex> lock(mLock);
+		if(mBound == UNBOUNDED) {
+			if(mClosed) {
+				return 0;
+			}
+			size_t before = mQueue.getSize();
+			mQueue.insert_range(first, last);
+			size_t pushed = mQueue.getSize() - before;
+			wakePops(pushed);
+			return pushed;
+		}
+
+		size_t pushed = 0;
+		while(first != last && waitForRoom(lock)) {
+			size_t room = mBound - mQueue.getSize();
+			size_t batch = 0;
+			for(; first != last && batch < room; ++first, ++batch) {
+				using std::get;
+				mQueue.insert(get<0>(*first), get<1>(*first));
+			}
+			pushed += batch;
+			wakePops(batch);
+		}
+		return pushed;
+	}
+
+	/**
+	 * Removes the element with the highest priority and moves it to
+	 * `item`, waiting while the queue is empty.
+	 *
+	 * @param item - set to the removed element
+	 * @return false if the queue is closed and empty, leaving `item` alone
+	 */
+	bool pop_wait(T& item) {
+		unique_lock<mutex> lock(mLock);
+		while(mQueue.empty() && !mClosed) {
+			mWaitingPops++;
+			mNotEmpty.wait(lock);
+			mWaitingPops--;
+		}
+		return popLocked(item);
+	}
+
+	/**
+	 * Removes the element with the highest priority and moves it to
+	 * `item`, waiting at most `timeout` while the queue is empty.
+	 *
+	 * @param item - set to the removed element
+	 * @param timeout - how long to wait for an element
+	 * @return false if the queue stayed empty, leaving `item` alone
+	 */
+	template<class Rep, class Period>
+	bool pop_for(T& item, const std::chrono::duration<Rep, Period>& timeout) {
+		std::chrono::steady_clock::time_point deadline =
+				std::chrono::steady_clock::now() + timeout;
+		unique_lock<mutex> lock(mLock);
+		while(mQueue.empty() && !mClosed) {
+			mWaitingPops++;
+			std::cv_status status = mNotEmpty.wait_until(lock, deadline);
+			mWaitingPops--;
+			if(status == std::cv_status::timeout) {
+				break;
+			}
+		}
+		return popLocked(item);
+	}
+
+	/**
+	 * Removes the element with the highest priority and moves it to
+	 * `item`, if there is one right now.
+	 *
+	 * @param item - set to the removed element
+	 * @return false if the queue was empty, leaving `item` alone
+	 */
+	bool try_pop(T& item) {
+		unique_lock<mutex> lock(mLock);
+		return popLocked(item);
+	}
+
+	/**
+	 * Waits while the queue is empty, then removes up to `k` elements in
+	 * priority order under the same lock acquisition, moving each one to
+	 * `out`.
+	 *
+	 * @param k - the maximum number of elements to remove
+	 * @param out - an output iterator to move the elements to
+	 * @return the number of elements removed: 0 only if the queue is closed
+	 *         and empty
+	 */
+	template<class OutputIt>
+	size_t pop_n_wait(size_t k, OutputIt out) {
+		unique_lock<mutex> lock(mLock);
+		while(mQueue.empty() && !mClosed) {
+			mWaitingPops++;
+			mNotEmpty.wait(lock);
+			mWaitingPops--;
+		}
+		size_t popped = (k < mQueue.getSize()) ? k : mQueue.getSize();
+		mQueue.pop_n(popped, out);
+		wakePushes(popped);
+		return popped;
+	}
+
+	/**
+	 * Closes the queue and wakes every waiting thread.
+	 *
+	 * Pushes fail from then on. Pops still take the items left, then fail
+	 * instead of waiting. Closing twice does nothing.
+	 */
+	void close() {
+		unique_lock<mutex> lock(mLock);
+		mClosed = true;
+		mNotEmpty.notify_all();
+		mNotFull.notify_all();
+	}
+
+	/**
+	 * Returns true if `close()` has been called.
+	 */
+	bool closed() const {
+		unique_lock<mutex> lock(mLock);
+		return mClosed;
+	}
+
+	/**
+	 * Returns true if container is empty.
+	 */
+	bool empty() const {
+		return (getSize() == 0);
+	}
+
+	/**
+	 * Returns the number of elements in the container. Other threads may
+	 * have changed it by the time it's returned.
+	 */
+	const size_t getSize() const {
+		unique_lock<mutex> lock(mLock);
+		return mQueue.getSize();
+	}
+
+	/**
+	 * Returns the most items the queue holds before pushes wait, or
+	 * `UNBOUNDED`.
+	 */
+	const size_t getBound() const {
+		return mBound;
+	}
+
+private:
+	mutable mutex mLock;
+	condition_variable mNotEmpty; // pops wait on this
+	condition_variable mNotFull; // pushes wait on this
+	Queue mQueue;
+	size_t mBound;
+	bool mClosed;
+	// Threads blocked (or just woken) on each condition, so that nobody is
+	// notified when nobody is waiting
+	size_t mWaitingPops;
+	size_t mWaitingPushes;
+
+	/**
+	 * Waits while the queue is full and open.
+	 *
+	 * @return false if the queue is closed
+	 */
+	bool waitForRoom(unique_lock<mutex>& lock) {
+		while(mQueue.getSize() >= mBound && !mClosed) {
+			mWaitingPushes++;
+			mNotFull.wait(lock);
+			mWaitingPushes--;
+		}
+		return !mClosed;
+	}
+
+	/**
+	 * Moves the top element to `item` and wakes a producer waiting for
+	 * room, if any. The lock must be held.
+	 *
+	 * @return false if the queue is empty
+	 */
+	bool popLocked(T& item) {
+		if(mQueue.empty()) {
+			return false;
+		}
+		item = mQueue.pop_value();
+		wakePushes(1);
+		return true;
+	}
+
+	/**
+	 * Wakes as many waiting consumers as `count` new items can feed.
+	 * Consumers only wait while the queue is empty, so this only signals
+	 * when the top goes from nothing to something.
+	 */
+	void wakePops(size_t count) {
+		wake(mNotEmpty, mWaitingPops, count);
+	}
+
+	/**
+	 * Wakes as many waiting producers as `count` freed slots can take.
+	 */
+	void wakePushes(size_t count) {
+		wake(mNotFull, mWaitingPushes, count);
+	}
+
+	static void wake(condition_variable& condition, size_t waiting,
+			size_t count) {
+		if(count >= waiting) {
+			if(waiting > 0) {
+				condition.notify_all();
+			}
+			return;
+		}
+		for(size_t i = 0; i < count; i++) {
+			condition.notify_one();
+		}
+	}
+};
+
+#endif /* BLOCKINGPRIORITYQUEUE_H_ */
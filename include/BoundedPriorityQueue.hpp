@@ -0,0 +1,193 @@
+/*
+ * BoundedPriorityQueue.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef BOUNDEDPRIORITYQUEUE_H_
+#define BOUNDEDPRIORITYQUEUE_H_
+
+#include <utility>
+using std::move;
+using std::forward;
+#include <functional>
+
+#include "PriorityQueue.hpp"
+
+/**
+ * Orders priorities the opposite way to `Compare`.
+ */
+template<class Compare>
+struct Reversed {
+	template<class Priority>
+	bool operator()(const Priority& a, const Priority& b) const {
+		return Compare()(b, a);
+	}
+};
+
+template<class Compare>
+struct KeyDirection<Reversed<Compare> > {
+	static const bool KNOWN = KeyDirection<Compare>::KNOWN;
+	static const bool HIGHEST_FIRST = !KeyDirection<Compare>::HIGHEST_FIRST;
+};
+
+/**
+ * Keeps the best `k` items of a stream, by `Compare`, in fixed memory.
+ *
+ * Items are kept in a `PriorityQueue` of capacity `k` ordered the other
+ * way, so the *worst* kept item is at the top. Once `k` items are kept, an
+ * item that isn't better than the worst is rejected after a single compare,
+ * and a better one replaces the worst with a single `~log k` sink. Memory
+ * never grows past `k` items, however long the stream.
+ *
+ * `drain()` hands the kept items over best first. Ties are kept
+ * first-come: an item that only ties the worst is rejected. Among tied
+ * items, the order of eviction and of `drain()` isn't specified, so the
+ * default `UnstableLayout` doesn't bother with insertion ids.
+ *
+ * The remaining template parameters are passed on to `PriorityQueue`.
+ */
+template<class T, class Priority=int,
+		 class Compare=std::greater<Priority>,
+		 class KeyLayout=UnstableLayout, size_t Arity=2>
+class BoundedPriorityQueue {
+public:
+	typedef PriorityQueue<T, Priority, Reversed<Compare>, KeyLayout, Arity>
+		Queue;
+
+	/**
+	 * Constructs a BoundedPriorityQueue that keeps the best `bound` items.
+	 *
+	 * All the memory it needs is allocated here.
+	 *
+	 * @param bound - the number of items to keep
+	 */
+	explicit BoundedPriorityQueue(size_t bound)
+		: mQueue(bound),
+		  mBound(bound),
+		  mCompare()
+	{}
+
+	/**
+	 * Offers `item` with priority `score`.
+	 *
+	 * @param item - the item to insert (copied)
+	 * @param score - the priority of this item
+	 * @return true if the item was kept
+	 */
+	bool insert(const T& item, const Priority& score) {
+		return emplace(score, item);
+	}
+
+	/**
+	 * Offers `item` with priority `score`, moving from `item` if it's kept.
+	 *
+	 * @param item - the item to insert (moved)
+	 * @param score - the priority of this item
+	 * @return true if the item was kept
+	 */
+	bool insert(T&& item, const Priority& score) {
+		return emplace(score, move(item));
+	}
+
+	/**
+	 * Offers an item with priority `score`, constructed in place from
+	 * `args` only if it's kept.
+	 *
+	 * This is a constant time operation if the item is rejected, and
+	 * `~log k` otherwise.
+	 *
+	 * @param score - the priority of the new item
+	 * @param args - arguments forwarded to the constructor of `T`
+	 * @return true if the item was kept
+	 */
+	template<class... Args>
+	bool emplace(const Priority& score, Args&&... args) {
+		if(mQueue.getSize() < mBound) {
+			mQueue.emplace(score, forward<Args>(args)...);
+			return true;
+		}
+		// Full: only something better than the worst gets in
+		if(mBound == 0 || !mCompare(score, mQueue.getTopPriority())) {
+			return false;
+		}
+		mQueue.emplace_top(score, forward<Args>(args)...);
+		return true;
+	}
+
+	/**
+	 * Returns a constant reference to the worst item kept: the next one
+	 * to be evicted.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	const T& worst() const {
+		return mQueue.top();
+	}
+
+	/**
+	 * Returns the priority of the worst item kept. Once the queue is full,
+	 * only better priorities get in.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	Priority getWorstPriority() const {
+		return mQueue.getTopPriority();
+	}
+
+	/**
+	 * Removes all items, best first, moving each one to `out`.
+	 *
+	 * This is a `~k log k` heapsort. The memory is kept for reuse.
+	 *
+	 * @param out - an output iterator to move the items to
+	 * @return `out`, advanced past the last item written
+	 */
+	template<class OutputIt>
+	OutputIt drain(OutputIt out) {
+		return mQueue.drain_reverse(out);
+	}
+
+	/**
+	 * Returns true if container is empty.
+	 */
+	bool empty() const {
+		return mQueue.empty();
+	}
+
+	/**
+	 * Returns true if `getBound()` items are kept, so new items must beat
+	 * the worst of them.
+	 */
+	bool full() const {
+		return mQueue.getSize() == mBound;
+	}
+
+	/**
+	 * Removes all items from the container.
+	 */
+	void clear() {
+		mQueue.clear();
+	}
+
+	/**
+	 * Returns the number of items kept.
+	 */
+	const size_t getSize() const {
+		return mQueue.getSize();
+	}
+
+	/**
+	 * Returns the most items that are kept.
+	 */
+	const size_t getBound() const {
+		return mBound;
+	}
+
+private:
+	Queue mQueue;
+	size_t mBound;
+	Compare mCompare;
+};
+
+#endif /* BOUNDEDPRIORITYQUEUE_H_ */
@@ -0,0 +1,538 @@
+/*
+ * BucketQueue.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef BUCKETQUEUE_H_
+#define BUCKETQUEUE_H_
+
+#include <stdexcept>
+using std::out_of_range;
+#include <memory>
+using std::allocator;
+using std::allocator_traits;
+#include <utility>
+using std::swap;
+using std::move;
+using std::forward;
+using std::move_if_noexcept;
+#include <vector>
+using std::vector;
+#include <cstdint>
+#include <cstring>
+#include <limits>
+using std::numeric_limits;
+#include <functional>
+#include <type_traits>
+
+#include "PriorityQueue.hpp"
+
+/**
+ * A priority queue for integral priorities in a small, fixed range.
+ *
+ * There's a first-in, first-out bucket for each priority in the range, and
+ * a bitmap of the buckets that aren't empty. The bitmap has a summary level
+ * (a bit per word) on top, and so on up to a single word, so the best
+ * bucket is found in a couple of instructions per level: one level covers
+ * 64 priorities, two cover 4096, three cover 262144.
+ *
+ * `insert()` and `pop()` are constant time, and ties leave first-in,
+ * first-out, like the default `PriorityQueue`. It has the same
+ * insert/top/pop interface.
+ *
+ * Items live in a pool of slots linked into per-bucket lists. Slots freed
+ * by `pop()` are reused, and the pool doubles when it's full. It doesn't
+ * shrink until `clear()`, which releases it back to its initial capacity.
+ *
+ * Only `std::greater` (highest first) and `std::less` (lowest first) are
+ * supported as `Compare`; see `KeyDirection`.
+ */
+template<class T, class Priority=int, class Compare=std::greater<Priority> >
+class BucketQueue : DynamicCollectionBase {
+	static_assert(std::is_integral<Priority>::value,
+			"BucketQueue needs an integral priority.");
+	static_assert(KeyDirection<Compare>::KNOWN,
+			"BucketQueue needs std::greater or std::less.");
+	typedef allocator_traits<allocator<T> > AllocTraits;
+public:
+
+	//--------------------------------------------------------------------------
+	// INSTANTIATION / COPY SEMANTICS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Constructs a BucketQueue for priorities in `[minPriority, maxPriority]`.
+	 *
+	 * Takes memory for a bucket per priority, so keep the range small.
+	 *
+	 * @param minPriority - the lowest priority that can be inserted
+	 * @param maxPriority - the highest priority that can be inserted
+	 * @param initialCapacity - starting size of the pool of item slots
+	 */
+	BucketQueue(Priority minPriority, Priority maxPriority,
+				size_t initialCapacity=DEFAULT_INITIAL_CAPACITY)
+		: mMinPriority(minPriority),
+		  mMaxPriority(maxPriority),
+		  mItemsAllocator(),
+		  mNextAllocator(),
+		  mInitialCapacity(initialCapacity > 0 ? initialCapacity : 1),
+		  mCapacity(mInitialCapacity),
+		  mSize(0),
+		  mNumUsed(0),
+		  mFree(NIL),
+		  mNumResizes(0)
+	{
+		if(maxPriority < minPriority) {
+			throw out_of_range("Your priority range is stupid.");
+		}
+		size_t numBuckets = static_cast<size_t>(maxPriority)
+				- static_cast<size_t>(minPriority) + 1;
+		mHeads.assign(numBuckets, NIL);
+		mTails.assign(numBuckets, NIL);
+
+		// A bit per bucket, then a bit per word, up to a single word
+		size_t numBits = numBuckets;
+		do {
+			size_t numWords = (numBits + 63) / 64;
+			mLevels.push_back(vector<uint64_t>(numWords, 0));
+			numBits = numWords;
+		} while(numBits > 1);
+
+		allocateArrays();
+	}
+
+	/**
+	 * Copy Constructor
+	 */
+	BucketQueue(const BucketQueue& src)
+		: mMinPriority(src.mMinPriority),
+		  mMaxPriority(src.mMaxPriority),
+		  mItemsAllocator(),
+		  mNextAllocator(),
+		  mHeads(src.mHeads),
+		  mTails(src.mTails),
+		  mLevels(src.mLevels),
+		  mInitialCapacity(src.mInitialCapacity),
+		  mCapacity(src.mCapacity),
+		  mSize(src.mSize),
+		  mNumUsed(src.mNumUsed),
+		  mFree(src.mFree),
+		  mNumResizes(src.mNumResizes)
+	{
+		allocateArrays();
+
+		// Links are plain indexes, so they copy as they are. Only the slots
+		// that hold items have anything to copy.
+		if(mNumUsed > 0) {
+			memcpy(mNext, src.mNext, mNumUsed*sizeof(size_t));
+		}
+		for(size_t b = 0; b < mHeads.size(); b++) {
+			for(size_t i = mHeads[b]; i != NIL; i = mNext[i]) {
+				AllocTraits::construct(mItemsAllocator, mItems+i, src.mItems[i]);
+			}
+		}
+	}
+
+	/**
+	 * Copy and move assignment operator.
+	 */
+	BucketQueue& operator=(BucketQueue rhs) {
+		swap(*this, rhs);
+		return *this;
+	}
+
+	/**
+	 * Move Constructor.
+	 *
+	 * Creates an empty object, then swaps `src` into it, leaving `src` barren.
+	 */
+	BucketQueue(BucketQueue&& src)
+		: BucketQueue(src.mMinPriority, src.mMinPriority, 1)
+	{
+		swap(*this, src);
+	}
+
+	/**
+	 * Swaps two instances of this user-defined object.
+	 */
+	friend void swap(BucketQueue& first, BucketQueue& second) {
+		using std::swap;
+		swap(first.mMinPriority, second.mMinPriority);
+		swap(first.mMaxPriority, second.mMaxPriority);
+		swap(first.mItems, second.mItems);
+		swap(first.mItemsAllocator, second.mItemsAllocator);
+		swap(first.mNext, second.mNext);
+		swap(first.mNextAllocator, second.mNextAllocator);
+		swap(first.mHeads, second.mHeads);
+		swap(first.mTails, second.mTails);
+		swap(first.mLevels, second.mLevels);
+		swap(first.mInitialCapacity, second.mInitialCapacity);
+		swap(first.mCapacity, second.mCapacity);
+		swap(first.mSize, second.mSize);
+		swap(first.mNumUsed, second.mNumUsed);
+		swap(first.mFree, second.mFree);
+		swap(first.mNumResizes, second.mNumResizes);
+	}
+
+	/// Destructor
+	virtual ~BucketQueue() {
+		destroyAllItems();
+		deallocateArrays();
+	}
+
+	//--------------------------------------------------------------------------
+	// PUBLIC METHODS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Inserts `item` of type `T` with priority `score`.
+	 *
+	 * This is a constant time operation unless the pool of slots needs to
+	 * be resized.
+	 *
+	 * @param item - the item to insert (copied)
+	 * @param score - the priority of this item
+	 * @throws out_of_range if `score` is outside the queue's range
+	 */
+	void insert(const T& item, const Priority& score) {
+		emplace(score, item);
+	}
+
+	/**
+	 * Inserts `item` of type `T` with priority `score`, moving from `item`.
+	 *
+	 * @param item - the item to insert (moved)
+	 * @param score - the priority of this item
+	 * @throws out_of_range if `score` is outside the queue's range
+	 */
+	void insert(T&& item, const Priority& score) {
+		emplace(score, move(item));
+	}
+
+	/**
+	 * Constructs an item of type `T` in place from `args` and inserts it
+	 * with priority `score`.
+	 *
+	 * @param score - the priority of the new item
+	 * @param args - arguments forwarded to the constructor of `T`
+	 * @throws out_of_range if `score` is outside the queue's range
+	 */
+	template<class... Args>
+	void emplace(const Priority& score, Args&&... args) {
+		size_t b = bucketOf(score);
+
+		size_t i;
+		if(mFree == NIL && mNumUsed == mCapacity) {
+			// `args` may refer to an item we're about to relocate,
+			// so build the new item before resizing up.
+			T item(forward<Args>(args)...);
+			resize(2 * mCapacity);
+			i = takeSlot();
+			AllocTraits::construct(mItemsAllocator, mItems+i, move(item));
+		} else {
+			i = takeSlot();
+			AllocTraits::construct(mItemsAllocator, mItems+i,
+					forward<Args>(args)...);
+		}
+
+		// Append to the back of the bucket
+		mNext[i] = NIL;
+		if(mTails[b] == NIL) {
+			mHeads[b] = i;
+			markBucket(b);
+		} else {
+			mNext[mTails[b]] = i;
+		}
+		mTails[b] = i;
+		mSize++;
+	}
+
+	/**
+	 * Returns a constant reference to the element with the highest priority.
+	 * Ties go to the earliest insertion.
+	 *
+	 * This is a constant time operation.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	const T& top() const {
+		return mItems[mHeads[topBucket()]];
+	}
+
+	/**
+	 * Returns the priority of the element with the highest priority.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	Priority getTopPriority() const {
+		return priorityOf(topBucket());
+	}
+
+	/**
+	 * Removes (and destroys) the element with the highest priority.
+	 *
+	 * This is a constant time operation.
+	 */
+	void pop() {
+		if(!empty()) {
+			size_t b = topBucket();
+			size_t i = mHeads[b];
+
+			// Unlink from the front of the bucket
+			mHeads[b] = mNext[i];
+			if(mHeads[b] == NIL) {
+				mTails[b] = NIL;
+				unmarkBucket(b);
+			}
+
+			AllocTraits::destroy(mItemsAllocator, mItems+i);
+			mNext[i] = mFree;
+			mFree = i;
+			mSize--;
+		}
+	}
+
+	/**
+	 * Removes the element with the highest priority and returns it.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	T pop_value() {
+		T item(move(mItems[mHeads[topBucket()]]));
+		pop();
+		return item;
+	}
+
+	/**
+	 * Returns true if container is empty.
+	 */
+	bool empty() const {
+		return (getSize() == 0);
+	}
+
+	/**
+	 * Removes all items from the container, and shrinks the pool back to
+	 * its initial capacity.
+	 */
+	void clear() {
+		destroyAllItems();
+		mHeads.assign(mHeads.size(), NIL);
+		mTails.assign(mTails.size(), NIL);
+		for(size_t level = 0; level < mLevels.size(); level++) {
+			mLevels[level].assign(mLevels[level].size(), 0);
+		}
+		mSize = 0;
+		mNumUsed = 0;
+		mFree = NIL;
+		if(mCapacity > mInitialCapacity) {
+			resize(mInitialCapacity);
+		}
+	}
+
+	/**
+	 * Returns the number of elements in the container.
+	 */
+	const size_t getSize() const {
+		return mSize;
+	}
+
+	/**
+	 * Returns the number of item slots in the pool.
+	 */
+	const size_t getCapacity() const {
+		return mCapacity;
+	}
+
+	/**
+	 * Returns the number of times the pool has been resized.
+	 */
+	const int getNumResizes() const {
+		return mNumResizes;
+	}
+
+private:
+	// The end of a list of slots
+	static const size_t NIL = numeric_limits<size_t>::max();
+
+	Priority mMinPriority;
+	Priority mMaxPriority;
+
+	// The pool of slots. `mNext` links each slot to the next in its bucket
+	// or, for free slots, to the next free slot.
+	T* mItems;
+	allocator<T> mItemsAllocator;
+	size_t* mNext;
+	allocator<size_t> mNextAllocator;
+
+	// The first and last slot of each bucket. The best bucket is the last.
+	vector<size_t> mHeads;
+	vector<size_t> mTails;
+	// Bitmaps of the non-empty buckets, then of the non-zero words below
+	vector<vector<uint64_t> > mLevels;
+
+	size_t mInitialCapacity; // `clear()` shrinks the pool back to this
+	size_t mCapacity;
+	size_t mSize;
+	size_t mNumUsed; // slots at or above this have never been used
+	size_t mFree; // the first free slot below `mNumUsed`
+	int mNumResizes;
+
+	//--------------------------------------------------------------------------
+	// PRIVATE METHODS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Allocate the pool.
+	 */
+	void allocateArrays() {
+		mItems = mItemsAllocator.allocate(mCapacity);
+		mNext = mNextAllocator.allocate(mCapacity);
+	}
+
+	/**
+	 * Deallocate the pool.
+	 */
+	void deallocateArrays() {
+		mItemsAllocator.deallocate(mItems, mCapacity);
+		mNextAllocator.deallocate(mNext, mCapacity);
+	}
+
+	/**
+	 * Destroy every item in every bucket.
+	 */
+	void destroyAllItems() {
+		for(size_t b = 0; b < mHeads.size(); b++) {
+			for(size_t i = mHeads[b]; i != NIL; i = mNext[i]) {
+				AllocTraits::destroy(mItemsAllocator, mItems+i);
+			}
+		}
+	}
+
+	/**
+	 * Returns an unused slot. The caller makes sure there is one.
+	 */
+	size_t takeSlot() {
+		if(mFree != NIL) {
+			size_t i = mFree;
+			mFree = mNext[i];
+			return i;
+		}
+		return mNumUsed++;
+	}
+
+	/**
+	 * Resizes the pool. Only called when every slot holds an item.
+	 *
+	 * @param newCapacity - the capacity to resize to
+	 */
+	void resize(size_t newCapacity) {
+		T* newItems = mItemsAllocator.allocate(newCapacity);
+		size_t* newNext = mNextAllocator.allocate(newCapacity);
+
+		relocateItems(newItems, mItems, IsTriviallyRelocatable<T>());
+		memcpy(newNext, mNext, mNumUsed*sizeof(size_t));
+
+		deallocateArrays();
+		mItems = newItems;
+		mNext = newNext;
+		mCapacity = newCapacity;
+
+		mNumResizes++;
+	}
+
+	/**
+	 * Relocates every item from `src` into the uninitialized array `dest`
+	 * with a single `memcpy`.
+	 */
+	void relocateItems(T* dest, T* src, std::true_type) {
+		memcpy(static_cast<void*>(dest), src, mNumUsed*sizeof(T));
+	}
+
+	/**
+	 * Relocates every item from `src` into the uninitialized array `dest`
+	 * by moving (or copying, if moving might throw) and destroying each one.
+	 */
+	void relocateItems(T* dest, T* src, std::false_type) {
+		for(size_t i=0; i < mNumUsed; i++) {
+			AllocTraits::construct(mItemsAllocator, dest+i,
+					move_if_noexcept(src[i]));
+			AllocTraits::destroy(mItemsAllocator, src+i);
+		}
+	}
+
+	/**
+	 * Returns the bucket for `score`. Better priorities get higher buckets.
+	 *
+	 * @throws out_of_range if `score` is outside the queue's range
+	 */
+	size_t bucketOf(const Priority& score) const {
+		if(score < mMinPriority || mMaxPriority < score) {
+			throw out_of_range("Priority is outside the BucketQueue's range.");
+		}
+		if(KeyDirection<Compare>::HIGHEST_FIRST) {
+			return static_cast<size_t>(score) - static_cast<size_t>(mMinPriority);
+		} else {
+			return static_cast<size_t>(mMaxPriority) - static_cast<size_t>(score);
+		}
+	}
+
+	/**
+	 * Inverts `bucketOf()`.
+	 */
+	Priority priorityOf(size_t b) const {
+		if(KeyDirection<Compare>::HIGHEST_FIRST) {
+			return static_cast<Priority>(static_cast<size_t>(mMinPriority) + b);
+		} else {
+			return static_cast<Priority>(static_cast<size_t>(mMaxPriority) - b);
+		}
+	}
+
+	/**
+	 * Returns the highest non-empty bucket, walking down the bitmap levels.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	size_t topBucket() const {
+		size_t idx = 0;
+		for(size_t level = mLevels.size(); level-- > 0; ) {
+			idx = idx * 64 + highestBit(mLevels[level][idx]);
+		}
+		return idx;
+	}
+
+	/**
+	 * Sets the bit of bucket `b`, and of each word above it that was zero.
+	 */
+	void markBucket(size_t b) {
+		for(size_t level = 0; level < mLevels.size(); level++) {
+			uint64_t& word = mLevels[level][b / 64];
+			bool wasEmpty = (word == 0);
+			word |= uint64_t(1) << (b % 64);
+			if(!wasEmpty) {
+				break;
+			}
+			b /= 64;
+		}
+	}
+
+	/**
+	 * Clears the bit of bucket `b`, and of each word above it that becomes
+	 * zero.
+	 */
+	void unmarkBucket(size_t b) {
+		for(size_t level = 0; level < mLevels.size(); level++) {
+			uint64_t& word = mLevels[level][b / 64];
+			word &= ~(uint64_t(1) << (b % 64));
+			if(word != 0) {
+				break;
+			}
+			b /= 64;
+		}
+	}
+};
+
+template<class T, class Priority, class Compare>
+const size_t BucketQueue<T, Priority, Compare>::NIL;
+
+#endif /* BUCKETQUEUE_H_ */
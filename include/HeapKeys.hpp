@@ -0,0 +1,980 @@
+/*
+ * HeapKeys.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef HEAPKEYS_H_
+#define HEAPKEYS_H_
+
+#include <utility>
+using std::swap;
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+using std::numeric_limits;
+#include <functional>
+#include <type_traits>
+
+/**
+ * Key layout that stores priorities and insertion ids of type `Id` in two
+ * parallel arrays. Together with the items array, that's the classic
+ * "triad".
+ *
+ * Comparisons only touch the ids array when priorities tie.
+ */
+template<class Id>
+struct BasicTriadLayout {};
+
+/**
+ * Triad with `size_t` ids, which never need renumbering in practice.
+ */
+typedef BasicTriadLayout<size_t> TriadLayout;
+
+/**
+ * Triad with 32-bit ids: half the id memory of `TriadLayout` on 64-bit
+ * targets, for the price of renumbering the ids every 4 billion or so
+ * insertions. Renumbering is `~n`, doesn't allocate, and keeps ties
+ * first-in, first-out.
+ */
+typedef BasicTriadLayout<uint32_t> CompactTriadLayout;
+
+/**
+ * Key layout that packs each priority and insertion id into a single
+ * ordered 64-bit key.
+ *
+ * Comparing two nodes is a single integer compare, and swapping two nodes
+ * touches one key array instead of two. Only works for integral priorities
+ * of up to 32 bits ordered by `std::greater` or `std::less`.
+ */
+struct FusedKeyLayout {};
+
+/**
+ * Key layout that stores priorities only.
+ *
+ * Items with equal priorities leave the queue in no particular order, but
+ * there are no insertion ids to store, compare or move.
+ */
+struct UnstableLayout {};
+
+/**
+ * Key layout that wraps another layout and makes the heap addressable.
+ *
+ * Every node gets a handle, which stays valid while the node moves around
+ * the heap and stops finding anything once the node leaves. A position map
+ * from handles to node indexes is kept up to date on every move and swap,
+ * so `PriorityQueue` can find a node by its handle in constant time and
+ * update or erase it in `~log n`.
+ *
+ * Costs one more array to move along with the keys, plus the map, which
+ * shares the heap's block.
+ */
+template<class Layout=TriadLayout>
+struct AddressableLayout {};
+
+/**
+ * The handle type of layouts that aren't addressable. It carries nothing.
+ */
+struct NoHandle {};
+
+/**
+ * The handle of an item in an addressable heap: the slot its position is
+ * kept in, and the stamp the item got when it was inserted.
+ *
+ * Slots are reused once their item leaves the heap, but stamps never are,
+ * so a handle kept after its item left won't find whatever took its slot.
+ * A default-constructed handle finds nothing.
+ */
+struct SlotHandle {
+	size_t mSlot;
+	uint64_t mStamp;
+
+	SlotHandle() : mSlot(0), mStamp(0) {}
+	SlotHandle(size_t slot, uint64_t stamp) : mSlot(slot), mStamp(stamp) {}
+
+	bool operator==(const SlotHandle& rhs) const {
+		return mSlot == rhs.mSlot && mStamp == rhs.mStamp;
+	}
+
+	bool operator!=(const SlotHandle& rhs) const {
+		return !(*this == rhs);
+	}
+};
+
+/**
+ * Tells `FusedKeyLayout` (and others that work on the bits of a priority)
+ * which way a comparator orders priorities.
+ *
+ * `KNOWN` is true if the direction is known. `HIGHEST_FIRST` is true if the
+ * comparator puts larger priorities first. Only the standard comparators
+ * are known; specialize it for others.
+ */
+template<class Compare>
+struct KeyDirection {
+	static const bool KNOWN = false;
+	static const bool HIGHEST_FIRST = false;
+};
+
+template<class Priority>
+struct KeyDirection<std::greater<Priority> > {
+	static const bool KNOWN = true;
+	static const bool HIGHEST_FIRST = true;
+};
+
+template<class Priority>
+struct KeyDirection<std::less<Priority> > {
+	static const bool KNOWN = true;
+	static const bool HIGHEST_FIRST = false;
+};
+
+#if __cplusplus >= 201402L
+template<>
+struct KeyDirection<std::greater<> > {
+	static const bool KNOWN = true;
+	static const bool HIGHEST_FIRST = true;
+};
+
+template<>
+struct KeyDirection<std::less<> > {
+	static const bool KNOWN = true;
+	static const bool HIGHEST_FIRST = false;
+};
+#endif
+
+/**
+ * Returns the index of the highest set bit of `word`, which mustn't be 0.
+ */
+inline unsigned highestBit(uint64_t word) {
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(word);
+#else
+	unsigned bit = 0;
+	while(word >>= 1) {
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+/**
+ * Returns the index of the lowest set bit of `word`, which mustn't be 0.
+ */
+inline unsigned lowestBit(uint64_t word) {
+#if defined(__GNUC__)
+	return __builtin_ctzll(word);
+#else
+	unsigned bit = 0;
+	while(!(word & 1)) {
+		word >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+// Assumed size of a cache line, in bytes
+static const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Returns the bytes `carve()` may take from a block for `capacity` `X`s,
+ * including padding.
+ */
+template<class X>
+constexpr size_t carvedSize(size_t capacity) {
+	return capacity * sizeof(X) + alignof(X) - 1;
+}
+
+/**
+ * Carves an array of `capacity` `X`s out of a block, at the first suitably
+ * aligned address from `cursor`.
+ *
+ * @param cursor - the next free byte of the block; advanced past the array
+ * @param capacity - the number of `X`s needed
+ * @return the array, uninitialized
+ */
+template<class X>
+X* carve(unsigned char*& cursor, size_t capacity) {
+	uintptr_t address = reinterpret_cast<uintptr_t>(cursor);
+	X* array = reinterpret_cast<X*>(
+			(address + alignof(X) - 1) / alignof(X) * alignof(X));
+	cursor = reinterpret_cast<unsigned char*>(array + capacity);
+	return array;
+}
+
+/**
+ * Returns the bytes `carveAligned()` may take from a block for `capacity`
+ * keys, including padding.
+ */
+template<class Key>
+constexpr size_t alignedSize(size_t capacity) {
+	return capacity * sizeof(Key) + CACHE_LINE_SIZE;
+}
+
+/**
+ * Carves an array of `capacity` keys out of a block, such that element 1
+ * (the first child of the root) starts a cache line. Since siblings are
+ * stored together, every group of siblings then starts at the same offset
+ * within a line. Keys whose size doesn't divide a line are just aligned.
+ *
+ * @param cursor - the next free byte of the block; advanced past the array
+ * @param capacity - the number of keys needed
+ * @return the aligned array, uninitialized
+ */
+template<class Key>
+Key* carveAligned(unsigned char*& cursor, size_t capacity) {
+	if(CACHE_LINE_SIZE % sizeof(Key) != 0) {
+		return carve<Key>(cursor, capacity);
+	}
+	uintptr_t child = reinterpret_cast<uintptr_t>(cursor) + sizeof(Key);
+	child = (child + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+	Key* keys = reinterpret_cast<Key*>(child - sizeof(Key));
+	cursor = reinterpret_cast<unsigned char*>(keys + capacity);
+	return keys;
+}
+
+/**
+ * The slot table of keys that hand out no handles, and so have none.
+ */
+struct NoSlotTable {
+	static constexpr size_t slotStorageSize(size_t) {
+		return 0;
+	}
+
+	void placeSlots(unsigned char*&, size_t) {}
+
+	size_t slotsFor(size_t, size_t) const {
+		return 0;
+	}
+
+	size_t getNumSlots() const {
+		return 0;
+	}
+};
+
+/**
+ * The ordering keys of a heap: everything `PriorityQueue` needs to compare
+ * and move its nodes, but not the items themselves.
+ *
+ * `Compare(a, b)` returns true if priority `a` should leave the heap
+ * before priority `b`.
+ *
+ * Specialized for each key layout. Each specialization provides:
+ *
+ *     typedef ... Handle; // returned by `insert()`; `NoHandle` if unaddressable
+ *     static const size_t MAX_ID; // ids are renumbered before reaching this
+ *     static constexpr size_t storageSize(size_t capacity); // bytes `place()` may take
+ *     void place(unsigned char*& cursor, size_t capacity); // carve the arrays
+ *     static constexpr size_t slotStorageSize(size_t slots); // bytes `placeSlots()` may take
+ *     void placeSlots(unsigned char*& cursor, size_t slots); // carve the slot table
+ *     size_t slotsFor(size_t capacity, size_t n) const; // table size for a new block
+ *     size_t getNumSlots() const;
+ *     void relocate(HeapKeys& dest, size_t n); // move `n` keys to `dest`
+ *     void copy(const HeapKeys& src, size_t n); // copy `n` keys from `src`
+ *     void construct(size_t i, const Priority& priority, size_t id);
+ *     void destroy(size_t i); // node `i` is leaving the heap
+ *     void move(size_t src, size_t dest);
+ *     void swap(size_t a, size_t b);
+ *     bool higher(size_t a, size_t b) const; // `a` leaves the heap first
+ *     Priority priority(size_t i) const;
+ *     size_t id(size_t i) const;
+ *     void setId(size_t i, size_t id);
+ *     bool cancelled(size_t i) const; // see `PriorityQueue::cancel()`
+ *     Handle handle(size_t i) const;
+ *
+ * Keys don't allocate: `PriorityQueue` allocates one block for its items
+ * and keys together, and each layout carves its arrays out of it, slot
+ * table included. Only addressable layouts have a slot table; the others
+ * get an empty one from `NoSlotTable`. Keys are trivially copyable and
+ * destructible, so they're moved with `memcpy` and there's nothing to
+ * destroy.
+ */
+template<class Layout, class Priority, class Compare>
+class HeapKeys;
+
+/**
+ * Keys stored as a triad (well, a pair) of parallel arrays.
+ */
+template<class Id, class Priority, class Compare>
+class HeapKeys<BasicTriadLayout<Id>, Priority, Compare> : public NoSlotTable {
+	static_assert(std::is_trivially_copyable<Priority>::value,
+			"Priorities must be trivially copyable.");
+	static_assert(std::is_integral<Id>::value && std::is_unsigned<Id>::value
+			&& sizeof(Id) <= sizeof(size_t),
+			"Ids must be unsigned integers no wider than size_t.");
+public:
+	typedef NoHandle Handle;
+
+	static const size_t MAX_ID = numeric_limits<Id>::max();
+
+	HeapKeys()
+		: mPriorities(nullptr),
+		  mIds(nullptr),
+		  mCompare()
+	{}
+
+	static constexpr size_t storageSize(size_t capacity) {
+		return alignedSize<Priority>(capacity) + alignedSize<Id>(capacity);
+	}
+
+	void place(unsigned char*& cursor, size_t capacity) {
+		mPriorities = carveAligned<Priority>(cursor, capacity);
+		mIds = carveAligned<Id>(cursor, capacity);
+	}
+
+	void relocate(HeapKeys& dest, size_t n) {
+		dest.copy(*this, n);
+	}
+
+	void copy(const HeapKeys& src, size_t n) {
+		if(n > 0) {
+			memcpy(static_cast<void*>(mPriorities), src.mPriorities,
+					n*sizeof(Priority));
+			memcpy(mIds, src.mIds, n*sizeof(Id));
+		}
+	}
+
+	void construct(size_t i, const Priority& priority, size_t id) {
+		mPriorities[i] = priority;
+		mIds[i] = static_cast<Id>(id);
+	}
+
+	void destroy(size_t) {}
+
+	void move(size_t src, size_t dest) {
+		mPriorities[dest] = mPriorities[src];
+		mIds[dest] = mIds[src];
+	}
+
+	void swap(size_t a, size_t b) {
+		using std::swap;
+		swap(mPriorities[a], mPriorities[b]);
+		swap(mIds[a], mIds[b]);
+	}
+
+	bool higher(size_t a, size_t b) const {
+		// Only look at ids when priorities tie
+		if(mCompare(mPriorities[a], mPriorities[b])) {
+			return true;
+		}
+		return !mCompare(mPriorities[b], mPriorities[a]) && mIds[a] < mIds[b];
+	}
+
+	Priority priority(size_t i) const {
+		return mPriorities[i];
+	}
+
+	size_t id(size_t i) const {
+		return mIds[i];
+	}
+
+	void setId(size_t i, size_t id) {
+		mIds[i] = static_cast<Id>(id);
+	}
+
+	const Priority* priorities() const {
+		return mPriorities;
+	}
+
+	bool cancelled(size_t) const {
+		return false;
+	}
+
+	Handle handle(size_t) const {
+		return Handle();
+	}
+
+	friend void swap(HeapKeys& first, HeapKeys& second) {
+		using std::swap;
+		swap(first.mPriorities, second.mPriorities);
+		swap(first.mIds, second.mIds);
+		swap(first.mCompare, second.mCompare);
+	}
+
+private:
+	Priority* mPriorities;
+	Id* mIds;
+	Compare mCompare;
+};
+
+/**
+ * Keys stored as a single array of priorities, with no insertion ids.
+ */
+template<class Priority, class Compare>
+class HeapKeys<UnstableLayout, Priority, Compare> : public NoSlotTable {
+	static_assert(std::is_trivially_copyable<Priority>::value,
+			"Priorities must be trivially copyable.");
+public:
+	typedef NoHandle Handle;
+
+	// There are no ids to run out of
+	static const size_t MAX_ID = numeric_limits<size_t>::max();
+
+	HeapKeys()
+		: mPriorities(nullptr),
+		  mCompare()
+	{}
+
+	static constexpr size_t storageSize(size_t capacity) {
+		return alignedSize<Priority>(capacity);
+	}
+
+	void place(unsigned char*& cursor, size_t capacity) {
+		mPriorities = carveAligned<Priority>(cursor, capacity);
+	}
+
+	void relocate(HeapKeys& dest, size_t n) {
+		dest.copy(*this, n);
+	}
+
+	void copy(const HeapKeys& src, size_t n) {
+		if(n > 0) {
+			memcpy(static_cast<void*>(mPriorities), src.mPriorities,
+					n*sizeof(Priority));
+		}
+	}
+
+	void construct(size_t i, const Priority& priority, size_t) {
+		mPriorities[i] = priority;
+	}
+
+	void destroy(size_t) {}
+
+	void move(size_t src, size_t dest) {
+		mPriorities[dest] = mPriorities[src];
+	}
+
+	void swap(size_t a, size_t b) {
+		using std::swap;
+		swap(mPriorities[a], mPriorities[b]);
+	}
+
+	bool higher(size_t a, size_t b) const {
+		return mCompare(mPriorities[a], mPriorities[b]);
+	}
+
+	Priority priority(size_t i) const {
+		return mPriorities[i];
+	}
+
+	size_t id(size_t) const {
+		return 0;
+	}
+
+	void setId(size_t, size_t) {}
+
+	const Priority* priorities() const {
+		return mPriorities;
+	}
+
+	bool cancelled(size_t) const {
+		return false;
+	}
+
+	Handle handle(size_t) const {
+		return Handle();
+	}
+
+	friend void swap(HeapKeys& first, HeapKeys& second) {
+		using std::swap;
+		swap(first.mPriorities, second.mPriorities);
+		swap(first.mCompare, second.mCompare);
+	}
+
+private:
+	Priority* mPriorities;
+	Compare mCompare;
+};
+
+/**
+ * Keys packed into one 64-bit integer per node.
+ *
+ * The priority, mapped to a 32-bit unsigned integer that orders the way
+ * `Compare` does, fills the high 32 bits. The complement of the id fills
+ * the low 32 bits. Higher priorities and then *lower* ids make bigger keys,
+ * so one unsigned compare gives the same FIFO ordering as `TriadLayout`.
+ *
+ * Ids only have 32 bits here, so `PriorityQueue` renumbers them every
+ * `MAX_ID` or so insertions.
+ */
+template<class Priority, class Compare>
+class HeapKeys<FusedKeyLayout, Priority, Compare> : public NoSlotTable {
+	static_assert(std::is_integral<Priority>::value && sizeof(Priority) <= 4,
+			"FusedKeyLayout needs an integral priority of at most 32 bits.");
+	static_assert(KeyDirection<Compare>::KNOWN,
+			"FusedKeyLayout needs std::greater or std::less.");
+public:
+	typedef uint64_t Key;
+	typedef NoHandle Handle;
+
+	static const size_t MAX_ID = 0xFFFFFFFFu;
+
+	HeapKeys() : mKeys(nullptr) {}
+
+	static constexpr size_t storageSize(size_t capacity) {
+		return alignedSize<Key>(capacity);
+	}
+
+	void place(unsigned char*& cursor, size_t capacity) {
+		mKeys = carveAligned<Key>(cursor, capacity);
+	}
+
+	void relocate(HeapKeys& dest, size_t n) {
+		dest.copy(*this, n);
+	}
+
+	void copy(const HeapKeys& src, size_t n) {
+		if(n > 0) {
+			memcpy(mKeys, src.mKeys, n*sizeof(Key));
+		}
+	}
+
+	void construct(size_t i, const Priority& priority, size_t id) {
+		Key hi = encode(priority);
+		Key lo = static_cast<uint32_t>(~id);
+		mKeys[i] = (hi << 32) | lo;
+	}
+
+	void destroy(size_t) {}
+
+	void move(size_t src, size_t dest) {
+		mKeys[dest] = mKeys[src];
+	}
+
+	void swap(size_t a, size_t b) {
+		using std::swap;
+		swap(mKeys[a], mKeys[b]);
+	}
+
+	bool higher(size_t a, size_t b) const {
+		return mKeys[a] > mKeys[b];
+	}
+
+	Priority priority(size_t i) const {
+		return decode(static_cast<uint32_t>(mKeys[i] >> 32));
+	}
+
+	size_t id(size_t i) const {
+		return static_cast<uint32_t>(~mKeys[i]);
+	}
+
+	void setId(size_t i, size_t id) {
+		construct(i, priority(i), id);
+	}
+
+	bool cancelled(size_t) const {
+		return false;
+	}
+
+	Handle handle(size_t) const {
+		return Handle();
+	}
+
+	friend void swap(HeapKeys& first, HeapKeys& second) {
+		using std::swap;
+		swap(first.mKeys, second.mKeys);
+	}
+
+private:
+	// Flipping the sign bit makes signed priorities order as unsigned
+	static const uint32_t SIGN_FLIP =
+			std::is_signed<Priority>::value ? (1u << (8*sizeof(Priority) - 1)) : 0;
+	// Flipping every bit reverses the order for lowest-first comparators
+	static const uint32_t ORDER_FLIP =
+			KeyDirection<Compare>::HIGHEST_FIRST ? 0 : 0xFFFFFFFFu;
+
+	Key* mKeys;
+
+	/**
+	 * Maps `priority` to an unsigned integer that's bigger when `Compare`
+	 * puts `priority` first.
+	 */
+	static uint32_t encode(Priority priority) {
+		typedef typename std::make_unsigned<Priority>::type Unsigned;
+		return (static_cast<Unsigned>(priority) ^ SIGN_FLIP) ^ ORDER_FLIP;
+	}
+
+	/**
+	 * Inverts `encode()`.
+	 */
+	static Priority decode(uint32_t bits) {
+		typedef typename std::make_unsigned<Priority>::type Unsigned;
+		return static_cast<Priority>(static_cast<Unsigned>(
+				(bits ^ ORDER_FLIP) ^ SIGN_FLIP));
+	}
+};
+
+/**
+ * Keys of another layout, plus a slot per node and a table of slots, each
+ * holding the node index and stamp of the node using it.
+ *
+ * A slot is released when its node leaves the heap and may be used again
+ * by a later `construct()`, with a new stamp. Handles carry the stamp, so
+ * `position()` rejects a handle whose node is gone. Released slots are
+ * chained into a free list through their positions.
+ *
+ * The table lives in the heap's block like the keys, with at least a slot
+ * per node of capacity. It only keeps more than that when the block shrinks
+ * below the highest slot still in use, since slots can't be renumbered
+ * without breaking handles.
+ *
+ * A node can also be cancelled: it stays in the heap, but its handle no
+ * longer finds it, until `PriorityQueue` gets around to removing it.
+ */
+template<class Layout, class Priority, class Compare>
+class HeapKeys<AddressableLayout<Layout>, Priority, Compare> {
+	typedef HeapKeys<Layout, Priority, Compare> Inner;
+public:
+	typedef SlotHandle Handle;
+
+	static const size_t MAX_ID = Inner::MAX_ID;
+	// The position of a handle whose node isn't in the heap
+	static const size_t NOT_IN_HEAP = numeric_limits<size_t>::max();
+
+	HeapKeys()
+		: mInner(),
+		  mSlots(nullptr),
+		  mPositions(nullptr),
+		  mStamps(nullptr),
+		  mNumSlots(0),
+		  mFreeSlot(NO_SLOT),
+		  mNextStamp(FIRST_STAMP)
+	{}
+
+	static constexpr size_t storageSize(size_t capacity) {
+		return Inner::storageSize(capacity) + carvedSize<size_t>(capacity);
+	}
+
+	void place(unsigned char*& cursor, size_t capacity) {
+		mInner.place(cursor, capacity);
+		mSlots = carve<size_t>(cursor, capacity);
+	}
+
+	static constexpr size_t slotStorageSize(size_t slots) {
+		return carvedSize<size_t>(slots) + carvedSize<uint64_t>(slots);
+	}
+
+	/**
+	 * Carves a table of `slots` slots, all free, out of a block.
+	 */
+	void placeSlots(unsigned char*& cursor, size_t slots) {
+		mPositions = carve<size_t>(cursor, slots);
+		mStamps = carve<uint64_t>(cursor, slots);
+		mNumSlots = slots;
+		for(size_t slot = 0; slot < slots; slot++) {
+			mStamps[slot] = FREE;
+		}
+		chainFreeSlots();
+	}
+
+	/**
+	 * Returns the table size for a block of `capacity` nodes that will get
+	 * this heap's first `n` nodes: `capacity`, or enough to keep every slot
+	 * those nodes use.
+	 */
+	size_t slotsFor(size_t capacity, size_t n) const {
+		size_t slots = capacity;
+		for(size_t i = 0; i < n; i++) {
+			if(mSlots[i] >= slots) {
+				slots = mSlots[i] + 1;
+			}
+		}
+		return slots;
+	}
+
+	size_t getNumSlots() const {
+		return mNumSlots;
+	}
+
+	void relocate(HeapKeys& dest, size_t n) {
+		mInner.relocate(dest.mInner, n);
+		dest.copySlots(*this, n);
+	}
+
+	void copy(const HeapKeys& src, size_t n) {
+		mInner.copy(src.mInner, n);
+		copySlots(src, n);
+	}
+
+	void construct(size_t i, const Priority& priority, size_t id) {
+		mInner.construct(i, priority, id);
+
+		// There's a slot per node of capacity, so one is always free
+		size_t slot = mFreeSlot;
+		mFreeSlot = mPositions[slot];
+		mPositions[slot] = i;
+		mStamps[slot] = mNextStamp++;
+		mSlots[i] = slot;
+	}
+
+	void destroy(size_t i) {
+		mInner.destroy(i);
+		size_t slot = mSlots[i];
+		mStamps[slot] = FREE;
+		mPositions[slot] = mFreeSlot;
+		mFreeSlot = slot;
+	}
+
+	void move(size_t src, size_t dest) {
+		mInner.move(src, dest);
+		mSlots[dest] = mSlots[src];
+		mPositions[mSlots[dest]] = dest;
+	}
+
+	void swap(size_t a, size_t b) {
+		using std::swap;
+		mInner.swap(a, b);
+		swap(mSlots[a], mSlots[b]);
+		mPositions[mSlots[a]] = a;
+		mPositions[mSlots[b]] = b;
+	}
+
+	bool higher(size_t a, size_t b) const {
+		return mInner.higher(a, b);
+	}
+
+	Priority priority(size_t i) const {
+		return mInner.priority(i);
+	}
+
+	/**
+	 * Changes the priority of node `i`, keeping its id.
+	 * The caller restores heap order.
+	 */
+	void setPriority(size_t i, const Priority& priority) {
+		mInner.construct(i, priority, mInner.id(i));
+	}
+
+	size_t id(size_t i) const {
+		return mInner.id(i);
+	}
+
+	void setId(size_t i, size_t id) {
+		mInner.setId(i, id);
+	}
+
+	/**
+	 * Marks node `i` as cancelled. Its slot is only released once the
+	 * node is destroyed.
+	 */
+	void cancel(size_t i) {
+		mStamps[mSlots[i]] = CANCELLED;
+	}
+
+	bool cancelled(size_t i) const {
+		return mStamps[mSlots[i]] == CANCELLED;
+	}
+
+	Handle handle(size_t i) const {
+		return Handle(mSlots[i], mStamps[mSlots[i]]);
+	}
+
+	const Inner& inner() const {
+		return mInner;
+	}
+
+	/**
+	 * Returns the index of the node with `handle`, or `NOT_IN_HEAP` if it
+	 * has left the heap or been cancelled. A handle from another heap may
+	 * find one of this heap's nodes.
+	 */
+	size_t position(Handle handle) const {
+		if(handle.mSlot >= mNumSlots
+				|| mStamps[handle.mSlot] != handle.mStamp
+				|| handle.mStamp < FIRST_STAMP) {
+			return NOT_IN_HEAP;
+		}
+		return mPositions[handle.mSlot];
+	}
+
+	friend void swap(HeapKeys& first, HeapKeys& second) {
+		using std::swap;
+		swap(first.mInner, second.mInner);
+		swap(first.mSlots, second.mSlots);
+		swap(first.mPositions, second.mPositions);
+		swap(first.mStamps, second.mStamps);
+		swap(first.mNumSlots, second.mNumSlots);
+		swap(first.mFreeSlot, second.mFreeSlot);
+		swap(first.mNextStamp, second.mNextStamp);
+	}
+
+private:
+	// Stamps below `FIRST_STAMP` mark slots without a live node
+	static const uint64_t FREE = 0;
+	static const uint64_t CANCELLED = 1;
+	static const uint64_t FIRST_STAMP = 2;
+	// Ends the free list
+	static const size_t NO_SLOT = numeric_limits<size_t>::max();
+
+	Inner mInner;
+	size_t* mSlots; // the slot of each node
+	size_t* mPositions; // the node index of each slot's node, or the next free slot
+	uint64_t* mStamps; // the stamp of each slot's node
+	size_t mNumSlots;
+	size_t mFreeSlot; // the first free slot, or `NO_SLOT`
+	uint64_t mNextStamp; // the stamp of the next inserted node
+
+	/**
+	 * Takes over the slots of the first `n` nodes of `src`, which this
+	 * table must be big enough for. Every other slot is free afterwards.
+	 */
+	void copySlots(const HeapKeys& src, size_t n) {
+		if(n > 0) {
+			memcpy(mSlots, src.mSlots, n*sizeof(size_t));
+		}
+		for(size_t i = 0; i < n; i++) {
+			size_t slot = mSlots[i];
+			mPositions[slot] = i;
+			mStamps[slot] = src.mStamps[slot];
+		}
+		mNextStamp = src.mNextStamp;
+		chainFreeSlots();
+	}
+
+	/**
+	 * Rebuilds the free list from the stamps, lowest slot first.
+	 */
+	void chainFreeSlots() {
+		mFreeSlot = NO_SLOT;
+		for(size_t slot = mNumSlots; slot-- > 0; ) {
+			if(mStamps[slot] == FREE) {
+				mPositions[slot] = mFreeSlot;
+				mFreeSlot = slot;
+			}
+		}
+	}
+};
+
+//------------------------------------------------------------------------------
+// ID CONSOLIDATION
+//------------------------------------------------------------------------------
+
+/**
+ * Sorts nodes `[lo, hi)` of a heap by id, in place.
+ *
+ * This is an American flag sort: a most significant digit first radix
+ * sort that swaps nodes straight into their bucket for the byte of the
+ * id at `shift`, then sorts each bucket by the next byte down. Small
+ * ranges are insertion sorted. With at most `sizeof(size_t)` bytes per
+ * id, it's a `~n` operation.
+ *
+ * @param swapNodes - swaps two nodes across all of the heap's arrays
+ */
+template<class Keys, class SwapNodes>
+void sortNodesById(const Keys& keys, size_t lo, size_t hi, unsigned shift,
+		SwapNodes& swapNodes) {
+	static const size_t INSERTION_SORT_SIZE = 32;
+	if(hi - lo <= INSERTION_SORT_SIZE) {
+		for(size_t i = lo + 1; i < hi; i++) {
+			for(size_t j = i; j > lo && keys.id(j) < keys.id(j - 1); j--) {
+				swapNodes(j, j - 1);
+			}
+		}
+		return;
+	}
+
+	// Count each bucket, then find where each one ends
+	size_t ends[256] = {};
+	for(size_t i = lo; i < hi; i++) {
+		ends[(keys.id(i) >> shift) & 0xFF]++;
+	}
+	size_t next[256];
+	size_t start = lo;
+	for(size_t b = 0; b < 256; b++) {
+		next[b] = start;
+		start += ends[b];
+		ends[b] = start;
+	}
+
+	// Swap each node into the next free slot of its bucket
+	for(size_t b = 0; b < 256; b++) {
+		while(next[b] < ends[b]) {
+			size_t d = (keys.id(next[b]) >> shift) & 0xFF;
+			if(d == b) {
+				next[b]++;
+			} else {
+				swapNodes(next[b], next[d]);
+				next[d]++;
+			}
+		}
+	}
+
+	if(shift > 0) {
+		size_t begin = lo;
+		for(size_t b = 0; b < 256; b++) {
+			if(ends[b] - begin > 1) {
+				sortNodesById(keys, begin, ends[b], shift - 8, swapNodes);
+			}
+			begin = ends[b];
+		}
+	}
+}
+
+/**
+ * Renumbers the ids of the first `size` nodes of a heap into the range
+ * [0, size), preserving their relative order.
+ *
+ * The nodes are sorted by id in place (see `sortNodesById()`) and given
+ * their index as their new id. Both steps are `~n`, and neither needs any
+ * extra memory. That leaves the nodes out of heap order; the caller must
+ * restore it.
+ *
+ * @param swapNodes - swaps two nodes across all of the heap's arrays
+ */
+template<class Keys, class SwapNodes>
+void compactNodeIds(Keys& keys, size_t size, SwapNodes swapNodes) {
+	if(size > 1) {
+		size_t maxId = 0;
+		for(size_t i = 0; i < size; i++) {
+			if(keys.id(i) > maxId) {
+				maxId = keys.id(i);
+			}
+		}
+		// Start with the highest byte that isn't 0 in every id
+		unsigned shift = (maxId > 0) ? highestBit(maxId) / 8 * 8 : 0;
+		sortNodesById(keys, 0, size, shift, swapNodes);
+	}
+
+	for(size_t i = 0; i < size; i++) {
+		keys.setId(i, i);
+	}
+}
+
+/**
+ * Frees up the ids of the first `size` nodes of a heap, preserving their
+ * relative order.
+ *
+ * Usually even the oldest node was inserted recently, so shifting every
+ * id down by the oldest one frees most of the ids in one pass, without
+ * moving any node. Otherwise, `compactNodeIds()` renumbers the nodes.
+ *
+ * Either way, this is a `~n` operation and allocates nothing.
+ *
+ * @param nextId - the id of the next inserted node; lowered to match
+ * @param swapNodes - swaps two nodes across all of the heap's arrays
+ * @return whether the nodes moved, in which case the caller must put them
+ *         back in heap order
+ */
+template<class Keys, class SwapNodes>
+bool consolidateNodeIds(Keys& keys, size_t size, size_t& nextId,
+		SwapNodes swapNodes) {
+	size_t oldest = nextId;
+	for(size_t i = 0; i < size; i++) {
+		if(keys.id(i) < oldest) {
+			oldest = keys.id(i);
+		}
+	}
+
+	if(oldest >= Keys::MAX_ID / 2) {
+		for(size_t i = 0; i < size; i++) {
+			keys.setId(i, keys.id(i) - oldest);
+		}
+		nextId -= oldest;
+		return false;
+	}
+	compactNodeIds(keys, size, swapNodes);
+	nextId = size;
+	return true;
+}
+
+#endif /* HEAPKEYS_H_ */
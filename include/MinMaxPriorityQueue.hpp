@@ -0,0 +1,343 @@
+/*
+ * MinMaxPriorityQueue.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef MINMAXPRIORITYQUEUE_H_
+#define MINMAXPRIORITYQUEUE_H_
+
+#include <utility>
+using std::move;
+using std::forward;
+#include <functional>
+#include <type_traits>
+
+#include "PriorityQueue.hpp"
+
+/**
+ * A double-ended priority queue: both the highest and the lowest priority
+ * items can be looked at in constant time and removed in `~log n`.
+ *
+ * This is a min-max heap (Atkinson et al., "Min-Max Heaps and Generalized
+ * Priority Queues", 1986) kept in the same arrays as a binary
+ * `PriorityQueue`, whose node machinery and resizing it reuses. Nodes on
+ * even levels (starting with the root) come before all their descendants,
+ * and nodes on odd levels after them. So the root is the highest priority
+ * item and the lowest is one of its children.
+ *
+ * Items are ordered as in `PriorityQueue`: by `Compare`, then first-in,
+ * first-out (except with `UnstableLayout`). `pop_max()` takes from the
+ * front of that order and `pop_min()` from the back, so among ties
+ * `pop_max()` takes the oldest item and `pop_min()` the newest.
+ *
+ * The remaining template parameters work as in `PriorityQueue`. Handles
+ * aren't supported.
+ */
+template<class T, class Priority=int,
+		 class Compare=std::greater<Priority>,
+		 class KeyLayout=TriadLayout,
+		 class GrowthPolicy=LinearGrowth, class Allocator=allocator<T> >
+class MinMaxPriorityQueue
+		: PriorityQueue<T, Priority, Compare, KeyLayout, 2, GrowthPolicy,
+						Allocator> {
+	typedef PriorityQueue<T, Priority, Compare, KeyLayout, 2, GrowthPolicy,
+						  Allocator> Base;
+	static_assert(std::is_same<typename Base::Handle, NoHandle>::value,
+			"MinMaxPriorityQueue doesn't support handles.");
+public:
+
+	//--------------------------------------------------------------------------
+	// INSTANTIATION / COPY SEMANTICS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Constructs a MinMaxPriorityQueue.
+	 *
+	 * The copy and move operations are those of `PriorityQueue`.
+	 *
+	 * @param initialCapacity - starting size of the backing data structure.
+	 * @param growthPolicy - decides how the backing data structure grows
+	 *                       when full and shrinks when sparse.
+	 * @param alloc - allocates the backing data structure.
+	 */
+	MinMaxPriorityQueue(
+			size_t initialCapacity=::DynamicCollectionBase::DEFAULT_INITIAL_CAPACITY,
+			GrowthPolicy growthPolicy=GrowthPolicy(),
+			const Allocator& alloc=Allocator())
+		: Base(initialCapacity, growthPolicy, alloc)
+	{}
+
+	/**
+	 * Swaps two instances of this user-defined object.
+	 */
+	friend void swap(MinMaxPriorityQueue& first, MinMaxPriorityQueue& second) {
+		swap(static_cast<Base&>(first), static_cast<Base&>(second));
+	}
+
+	//--------------------------------------------------------------------------
+	// PUBLIC METHODS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Inserts `item` of type `T` with priority `score`.
+	 *
+	 * This is a `~log n` operation unless the backing data structure
+	 * needs to be resized.
+	 *
+	 * @param item - the item to insert (copied)
+	 * @param score - the priority of this item
+	 */
+	void insert(const T& item, const Priority& score) {
+		emplace(score, item);
+	}
+
+	/**
+	 * Inserts `item` of type `T` with priority `score`, moving from `item`.
+	 *
+	 * @param item - the item to insert (moved)
+	 * @param score - the priority of this item
+	 */
+	void insert(T&& item, const Priority& score) {
+		emplace(score, move(item));
+	}
+
+	/**
+	 * Constructs an item of type `T` in place from `args` and inserts it
+	 * with priority `score`.
+	 *
+	 * @param score - the priority of the new item
+	 * @param args - arguments forwarded to the constructor of `T`
+	 */
+	template<class... Args>
+	void emplace(const Priority& score, Args&&... args) {
+		pushUp(this->emplaceBack(score, forward<Args>(args)...));
+	}
+
+	/**
+	 * Returns a constant reference to the element with the highest priority.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	const T& top_max() const {
+		return this->mItems[0];
+	}
+
+	/**
+	 * Returns a constant reference to the element with the lowest priority.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	const T& top_min() const {
+		return this->mItems[minIdx()];
+	}
+
+	/**
+	 * Returns the highest priority.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	Priority getMaxPriority() const {
+		return this->mKeys.priority(0);
+	}
+
+	/**
+	 * Returns the lowest priority.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	Priority getMinPriority() const {
+		return this->mKeys.priority(minIdx());
+	}
+
+	/**
+	 * Removes (and destroys) the element with the highest priority.
+	 *
+	 * This is a `~log n` operation unless the backing data structure needs
+	 * to be resized.
+	 */
+	void pop_max() {
+		if(!empty()) {
+			removeAt(0);
+		}
+	}
+
+	/**
+	 * Removes (and destroys) the element with the lowest priority.
+	 *
+	 * This is a `~log n` operation unless the backing data structure needs
+	 * to be resized.
+	 */
+	void pop_min() {
+		if(!empty()) {
+			removeAt(minIdx());
+		}
+	}
+
+	/**
+	 * Removes the element with the highest priority and returns it.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	T pop_max_value() {
+		T item(move(this->mItems[0]));
+		pop_max();
+		return item;
+	}
+
+	/**
+	 * Removes the element with the lowest priority and returns it.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	T pop_min_value() {
+		T item(move(this->mItems[minIdx()]));
+		pop_min();
+		return item;
+	}
+
+	using Base::empty;
+	using Base::clear;
+	using Base::reserve;
+	using Base::shrink_to_fit;
+	using Base::getSize;
+	using Base::getCapacity;
+	using Base::getNumResizes;
+	using Base::getAllocator;
+
+private:
+
+	//--------------------------------------------------------------------------
+	// PRIVATE METHODS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Returns the index of the node with the lowest priority: the last of
+	 * the root's children, or the root if it has none.
+	 */
+	size_t minIdx() const {
+		if(this->mSize <= 2) {
+			return this->mSize - 1;
+		}
+		return before(1, 2) ? 2 : 1;
+	}
+
+	/**
+	 * Returns true if node `a` leaves the max end before node `b`.
+	 */
+	bool before(size_t a, size_t b) const {
+		return this->mKeys.higher(a, b);
+	}
+
+	/**
+	 * Returns true if node `i` is on a max level (an even one).
+	 */
+	static bool onMaxLevel(size_t i) {
+		return highestBit(i + 1) % 2 == 0;
+	}
+
+	/**
+	 * Removes node `i`, the max or the min, then shrinks the backing data
+	 * structure if needed.
+	 */
+	void removeAt(size_t i) {
+		if(this->unlinkNode(i)) {
+			// Nothing comes before the max or after the min,
+			// so the node moved into its place can only go down
+			pushDown(i);
+		}
+		this->checkCapacity();
+	}
+
+	/**
+	 * Puts all the nodes in min-max heap order, bottom-up.
+	 */
+	void rebuildHeap() {
+		for(size_t i = this->mSize / 2; i-- > 0; ) {
+			pushDown(i);
+		}
+	}
+
+	/**
+	 * Moves a new leaf `i` up to its place.
+	 */
+	void pushUp(size_t i) {
+		if(i == 0) {
+			return;
+		}
+		size_t parent = (i - 1) / 2;
+		if(onMaxLevel(i)) {
+			if(before(parent, i)) {
+				// It belongs with the min levels
+				this->swapNodes(i, parent);
+				pushUpAlong(parent, false);
+			} else {
+				pushUpAlong(i, true);
+			}
+		} else {
+			if(before(i, parent)) {
+				// It belongs with the max levels
+				this->swapNodes(i, parent);
+				pushUpAlong(parent, true);
+			} else {
+				pushUpAlong(i, false);
+			}
+		}
+	}
+
+	/**
+	 * Moves node `i` up through its grandparents, which are on max levels
+	 * if `max` and min levels otherwise.
+	 */
+	void pushUpAlong(size_t i, bool max) {
+		while(i > 2) {
+			size_t grandparent = (i - 3) / 4;
+			if(max ? !before(i, grandparent) : !before(grandparent, i)) {
+				return;
+			}
+			this->swapNodes(i, grandparent);
+			i = grandparent;
+		}
+	}
+
+	/**
+	 * Moves node `i` down to its place.
+	 */
+	void pushDown(size_t i) {
+		bool max = onMaxLevel(i);
+		size_t size = this->mSize;
+		while(2*i + 1 < size) {
+			// Find the most extreme of the children and grandchildren
+			size_t m = 2*i + 1;
+			size_t candidates[] = { 2*i + 2, 4*i + 3, 4*i + 4, 4*i + 5, 4*i + 6 };
+			for(size_t c : candidates) {
+				if(c < size && (max ? before(c, m) : before(m, c))) {
+					m = c;
+				}
+			}
+
+			if(max ? !before(m, i) : !before(i, m)) {
+				return;
+			}
+			this->swapNodes(m, i);
+			if(m <= 2*i + 2) {
+				// A child only beats its own children if they tie with it,
+				// as they'd come before it otherwise (it's on the other kind
+				// of level). The same goes for their children, and so on,
+				// so its whole subtree ties with it and node `i`, which it
+				// came before, fits in its place.
+				return;
+			}
+
+			// A grandchild: node `i` went down two levels, and may now be
+			// out of order with its new parent, on the other kind of level
+			size_t parent = (m - 1) / 2;
+			if(max ? before(parent, m) : before(m, parent)) {
+				this->swapNodes(m, parent);
+			}
+			i = m;
+		}
+	}
+};
+
+#endif /* MINMAXPRIORITYQUEUE_H_ */
@@ -0,0 +1,271 @@
+/*
+ * MultiQueue.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef MULTIQUEUE_H_
+#define MULTIQUEUE_H_
+
+#include <atomic>
+using std::atomic;
+#include <mutex>
+using std::mutex;
+using std::unique_lock;
+using std::try_to_lock;
+using std::adopt_lock;
+#include <thread>
+#include <vector>
+using std::vector;
+#include <cstdint>
+#include <stdexcept>
+using std::out_of_range;
+
+#include "PriorityQueue.hpp"
+
+/**
+ * A relaxed concurrent priority queue for many threads, built from several
+ * `PriorityQueue` shards.
+ *
+ * This is a MultiQueue (Rihani, Sanders & Dementiev, "MultiQueues: Simple
+ * Relaxed Concurrent Priority Queues", 2015). Each shard has its own lock.
+ * `insert()` puts the item in a random shard whose lock it can take without
+ * waiting. `try_pop()` looks at the top priorities of two random shards,
+ * cached in atomics so that looking takes no lock, and pops from the better
+ * one. Threads rarely wait for each other, but the order is relaxed:
+ *
+ * - A pop doesn't always return the best item in the whole queue. The rank
+ *   of a popped item (how many better items were left behind) is on the
+ *   order of the number of shards in expectation, and much worse ranks are
+ *   exponentially unlikely. No item is starved: every pop from its shard
+ *   brings it closer to the top.
+ * - Ties are first-in, first-out within a shard only.
+ * - `try_pop()` only returns false if every shard looked empty, which can
+ *   happen while another thread is in the middle of inserting.
+ *
+ * The remaining template parameters configure the shards (see
+ * `PriorityQueue`). Handles aren't supported.
+ *
+ * All methods may be called concurrently, except construction and
+ * destruction.
+ */
+template<class T, class Priority=int,
+		 class Compare=std::greater<Priority>,
+		 class KeyLayout=TriadLayout, size_t Arity=2,
+		 class GrowthPolicy=LinearGrowth>
+class MultiQueue : DynamicCollectionBase {
+public:
+	typedef PriorityQueue<T, Priority, Compare, KeyLayout, Arity, GrowthPolicy>
+		Queue;
+
+	// Default number of shards per thread
+	static const size_t DEFAULT_SHARDS_PER_THREAD = 2;
+
+	/**
+	 * Constructs a MultiQueue.
+	 *
+	 * More shards mean less contention but a more relaxed order. Two per
+	 * thread is the usual choice.
+	 *
+	 * @param numShards - the number of shards. Defaults to
+	 *                    `DEFAULT_SHARDS_PER_THREAD` per hardware thread.
+	 * @param initialCapacity - starting size of each shard.
+	 * @param growthPolicy - decides how each shard grows and shrinks.
+	 */
+	MultiQueue(size_t numShards=defaultNumShards(),
+			   size_t initialCapacity=DEFAULT_INITIAL_CAPACITY,
+			   GrowthPolicy growthPolicy=GrowthPolicy())
+		: mShards(numShards),
+		  mCompare()
+	{
+		if(numShards == 0) {
+			throw out_of_range("A MultiQueue needs at least one shard.");
+		}
+		for(size_t i = 0; i < numShards; i++) {
+			mShards[i].mQueue = Queue(initialCapacity, growthPolicy);
+		}
+	}
+
+	MultiQueue(const MultiQueue&) = delete;
+	MultiQueue& operator=(const MultiQueue&) = delete;
+
+	/**
+	 * Inserts `item` with priority `score` into a random shard.
+	 *
+	 * @param item - the item to insert (copied)
+	 * @param score - the priority of this item
+	 */
+	void insert(const T& item, const Priority& score) {
+		Shard& shard = lockRandomShard();
+		unique_lock<mutex> lock(shard.mLock, adopt_lock);
+		shard.mQueue.insert(item, score);
+		publishTop(shard);
+	}
+
+	/**
+	 * Inserts `item` with priority `score` into a random shard, moving from
+	 * `item`.
+	 *
+	 * @param item - the item to insert (moved)
+	 * @param score - the priority of this item
+	 */
+	void insert(T&& item, const Priority& score) {
+		Shard& shard = lockRandomShard();
+		unique_lock<mutex> lock(shard.mLock, adopt_lock);
+		shard.mQueue.insert(move(item), score);
+		publishTop(shard);
+	}
+
+	/**
+	 * Removes an element with (nearly) the highest priority and moves it
+	 * to `item`.
+	 *
+	 * @param item - set to the removed element
+	 * @return false if the queue looked empty, leaving `item` alone
+	 */
+	bool try_pop(T& item) {
+		while(true) {
+			// Pick the better of two random shards...
+			Shard* shard = better(randomShard(), randomShard());
+			if(shard == nullptr) {
+				// ...or if both looked empty, the best of all of them.
+				shard = best();
+				if(shard == nullptr) {
+					return false;
+				}
+			}
+
+			unique_lock<mutex> lock(shard->mLock, try_to_lock);
+			// Someone else may have got there first
+			if(lock.owns_lock() && !shard->mQueue.empty()) {
+				item = shard->mQueue.pop_value();
+				publishTop(*shard);
+				return true;
+			}
+		}
+	}
+
+	/**
+	 * Returns true if every shard looked empty.
+	 *
+	 * Only a hint while other threads are inserting or popping.
+	 */
+	bool empty() const {
+		for(size_t i = 0; i < mShards.size(); i++) {
+			if(mShards[i].mHasTop.load(std::memory_order_relaxed)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Returns the number of shards.
+	 */
+	const size_t getNumShards() const {
+		return mShards.size();
+	}
+
+private:
+	/**
+	 * A `PriorityQueue` with its lock and a cached copy of its top priority.
+	 */
+	struct Shard {
+		Shard() : mHasTop(false), mTop() {}
+
+		mutex mLock;
+		Queue mQueue;
+		// Written under `mLock`, read without it. They're only hints, so
+		// relaxed ordering is enough; the lock orders the queue itself.
+		atomic<bool> mHasTop;
+		atomic<Priority> mTop;
+		// Keep neighboring shards off each other's cache lines
+		char mPadding[CACHE_LINE_SIZE];
+	};
+
+	vector<Shard> mShards;
+	Compare mCompare;
+
+	/**
+	 * Returns `DEFAULT_SHARDS_PER_THREAD` shards per hardware thread.
+	 */
+	static size_t defaultNumShards() {
+		size_t threads = std::thread::hardware_concurrency();
+		return DEFAULT_SHARDS_PER_THREAD * (threads > 0 ? threads : 1);
+	}
+
+	/**
+	 * Returns a random shard.
+	 *
+	 * Each thread has its own xorshift generator, so this takes no lock.
+	 */
+	Shard& randomShard() {
+		static atomic<uint32_t> nextSeed(0);
+		thread_local uint32_t state =
+				(nextSeed.fetch_add(0x9E3779B9u) + 0x9E3779B9u) | 1;
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return mShards[state % mShards.size()];
+	}
+
+	/**
+	 * Locks and returns a random shard, trying others while it's busy.
+	 */
+	Shard& lockRandomShard() {
+		while(true) {
+			Shard& shard = randomShard();
+			if(shard.mLock.try_lock()) {
+				return shard;
+			}
+		}
+	}
+
+	/**
+	 * Updates the cached top of `shard`. Call with its lock held.
+	 */
+	void publishTop(Shard& shard) {
+		if(shard.mQueue.empty()) {
+			shard.mHasTop.store(false, std::memory_order_relaxed);
+		} else {
+			shard.mTop.store(shard.mQueue.getTopPriority(),
+					std::memory_order_relaxed);
+			shard.mHasTop.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * Returns whichever of `a` and `b` looks like it has the higher top,
+	 * or null if both look empty.
+	 */
+	Shard* better(Shard& a, Shard& b) const {
+		bool aHasTop = a.mHasTop.load(std::memory_order_relaxed);
+		bool bHasTop = b.mHasTop.load(std::memory_order_relaxed);
+		if(!aHasTop) {
+			return bHasTop ? &b : nullptr;
+		}
+		if(!bHasTop) {
+			return &a;
+		}
+		return mCompare(b.mTop.load(std::memory_order_relaxed),
+						a.mTop.load(std::memory_order_relaxed)) ? &b : &a;
+	}
+
+	/**
+	 * Returns the shard that looks like it has the highest top, or null if
+	 * they all look empty.
+	 */
+	Shard* best() {
+		Shard* bestShard = nullptr;
+		for(size_t i = 0; i < mShards.size(); i++) {
+			if(bestShard == nullptr) {
+				bestShard = better(mShards[i], mShards[i]);
+			} else {
+				bestShard = better(*bestShard, mShards[i]);
+			}
+		}
+		return bestShard;
+	}
+};
+
+#endif /* MULTIQUEUE_H_ */
@@ -10,12 +10,38 @@
 
 #include <stdexcept>
 using std::runtime_error;
+using std::out_of_range;
+using std::length_error;
 #include <memory>
 using std::allocator;
+using std::allocator_traits;
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
 #include <utility>
 using std::swap;
+using std::move;
+using std::forward;
+using std::move_if_noexcept;
+#include <type_traits>
+#include <cstring>
 #include <limits>
 using std::numeric_limits;
+#include <string>
+using std::string;
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <vector>
+using std::vector;
+#include <algorithm>
+using std::sort;
+#include <functional>
+#include <iterator>
+#include <tuple>
+
+#include "HeapKeys.hpp"
+#include "SiblingSelect.hpp"
 
 /**
  * A base class for dynamically-resized containers.
@@ -26,17 +52,167 @@ struct DynamicCollectionBase {
 	static const size_t DEFAULT_INITIAL_CAPACITY = 30;
 	// Default amount to increment capacity during automatic resizing
 	static const size_t DEFAULT_STEP_SIZE = 10;
-	// The maximum id assigned to contained items. 
+	// Default multiplier for capacity during geometric resizing
+	static constexpr double DEFAULT_GROWTH_FACTOR = 2.0;
+	// The maximum id assigned to contained items.
 	// Ids are assigned in order of insertion and used to break priority ties.
 	static const size_t MAX_ID = numeric_limits<size_t>::max();
 	static const bool DEBUG = false;
 };
 
+/**
+ * Whether a `T` can be moved to a new address with a plain `memcpy`,
+ * leaving the old bytes to be discarded without running a destructor.
+ *
+ * `PriorityQueue` relocates items this way when resizing. It's true for
+ * trivially copyable types. Specialize it for types you know to be safe.
+ */
+template<class T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+/**
+ * Growth policy that grows and shrinks capacity by a fixed step.
+ *
+ * This is the classic behavior of `PriorityQueue`. It keeps memory tight,
+ * but filling a queue to `n` items takes `n / stepSize` resizes, each of
+ * which moves every item. Prefer `GeometricGrowth` for large queues.
+ *
+ * A growth policy needs two methods:
+ *
+ *     size_t grow(size_t capacity) const; // new capacity when full
+ *     size_t shrink(size_t capacity, size_t size) const; // or `capacity`
+ */
+class LinearGrowth {
+public:
+	/**
+	 * Constructs a LinearGrowth policy.
+	 *
+	 * Not `explicit`, so a plain step size can be passed wherever a
+	 * `LinearGrowth` is expected.
+	 *
+	 * @param stepSize - the size by which the size of the backing data
+	 *                   structure is increased when it is full.
+	 */
+	LinearGrowth(size_t stepSize=DynamicCollectionBase::DEFAULT_STEP_SIZE)
+		: mStepSize(stepSize),
+		  mStepSize2x(2*stepSize)
+	{
+		// If the stepSize is zero, or doubling it would overflow size_t
+		if(stepSize == 0 || stepSize > DynamicCollectionBase::MAX_ID / 2) {
+			throw out_of_range("Your `stepSize` is stupid.");
+		}
+	}
+
+	/**
+	 * Returns the capacity to grow to from a full `capacity`.
+	 */
+	size_t grow(size_t capacity) const {
+		if(mStepSize > DynamicCollectionBase::MAX_ID - capacity) {
+			throw length_error("PriorityQueue capacity would overflow.");
+		}
+		return capacity + mStepSize;
+	}
+
+	/**
+	 * Returns the capacity to shrink to when `size` items are stored in
+	 * `capacity` slots, or `capacity` if no shrink is due.
+	 */
+	size_t shrink(size_t capacity, size_t size) const {
+		// remember size_t is unsigned
+		// If we've shrunk enough, step down to free memory
+		if(capacity >= mStepSize2x && size < (capacity - mStepSize2x)) {
+			return capacity - mStepSize;
+		}
+		return capacity;
+	}
+
+private:
+	size_t mStepSize;
+	size_t mStepSize2x; // cache this for performance
+};
+
+/**
+ * Growth policy that multiplies capacity by a constant factor when full.
+ *
+ * Inserts are amortized constant time. Shrinking divides capacity by the
+ * same factor, but only once the queue is less than `1/factor^2` full, so
+ * the queue is still at most `1/factor` full after shrinking. That gap
+ * keeps alternating inserts and pops near a boundary from thrashing.
+ */
+class GeometricGrowth {
+public:
+	/**
+	 * Constructs a GeometricGrowth policy.
+	 *
+	 * @param growthFactor - the multiplier applied to a full capacity.
+	 *                       Must be greater than 1.
+	 */
+	GeometricGrowth(
+			double growthFactor=DynamicCollectionBase::DEFAULT_GROWTH_FACTOR)
+		: mGrowthFactor(growthFactor),
+		  mShrinkDivisor(growthFactor*growthFactor)
+	{
+		if(!(growthFactor > 1.0)) {
+			throw out_of_range("Your `growthFactor` is stupid.");
+		}
+	}
+
+	/**
+	 * Returns the capacity to grow to from a full `capacity`.
+	 */
+	size_t grow(size_t capacity) const {
+		double grown = capacity * mGrowthFactor;
+		if(grown >= static_cast<double>(DynamicCollectionBase::MAX_ID)) {
+			throw length_error("PriorityQueue capacity would overflow.");
+		}
+		size_t newCapacity = static_cast<size_t>(grown);
+		// Small capacities may not grow at all after truncation
+		return (newCapacity > capacity) ? newCapacity : capacity + 1;
+	}
+
+	/**
+	 * Returns the capacity to shrink to when `size` items are stored in
+	 * `capacity` slots, or `capacity` if no shrink is due.
+	 */
+	size_t shrink(size_t capacity, size_t size) const {
+		if(size < capacity / mShrinkDivisor) {
+			return static_cast<size_t>(capacity / mGrowthFactor);
+		}
+		return capacity;
+	}
+
+private:
+	double mGrowthFactor;
+	double mShrinkDivisor; // cache this for performance
+};
+
 /**
  * A dynamically-resized priority queue implementation.
  *
- * This priority queue is backed by a triad of heap-sorted arrays for
- * optimal performance.
+ * Items are ordered by a `Priority` (an `int` by default). `Compare(a, b)`
+ * returns true if priority `a` should leave the queue before priority `b`,
+ * so the default `std::greater` pops the highest priority first and
+ * `std::less` makes a min-queue. The comparator is a template parameter,
+ * so calls to it are inlined.
+ *
+ * This priority queue is backed by heap-sorted arrays: one of items and,
+ * depending on `KeyLayout`, one or two of ordering keys. The default
+ * `TriadLayout` keeps priorities and insertion ids in separate arrays, and
+ * breaks priority ties first-in, first-out; `CompactTriadLayout` does the
+ * same with 32-bit ids. `UnstableLayout` drops the
+ * ids (and the FIFO guarantee). `FusedKeyLayout` packs priority and id
+ * into one 64-bit key per node. Wrapping any of them in `AddressableLayout`
+ * makes `insert()` return a handle, which can later be passed to `update()`,
+ * `erase()` or `cancel()`. See HeapKeys.hpp.
+ *
+ * The heap is `Arity`-ary (binary by default). Wider heaps are shallower,
+ * so popping visits fewer levels and takes fewer cache misses, at the cost
+ * of comparing more siblings per level. Key arrays are aligned so that
+ * each group of siblings starts on a cache line; with `Arity` times the
+ * key size equal to 64 bytes (e.g. a 4-ary triad or an 8-ary fused
+ * layout) every group fills exactly one line. Built for SSE4.1 or AVX2,
+ * 4- and 8-ary heaps compare a group of siblings in a few vector
+ * instructions (see SiblingSelect.hpp).
  *
  * It's recommended that one wrap objects in a smart pointer
  * (like `std::shared_ptr) before inserting them into the queue.
@@ -48,21 +224,52 @@ struct DynamicCollectionBase {
  *         myPriorityQueue.pop(); // Remove and destroy
  *     }
  *
- * This implementation uses std::allocator because
+ * or, to move the top out instead of copying it, in one step:
  *
- * 1. The STL containers use it
- * 2. It seems to be the best way to destroy an arbitrary object without
- *        explicitly calling the objects destructor.
+ *     T myObject = myPriorityQueue.pop_value();
+ *
+ * Resizing is delegated to `GrowthPolicy` (see `LinearGrowth` and
+ * `GeometricGrowth`). The queue never shrinks below its initial capacity
+ * or below a capacity requested with `reserve()`.
+ *
+ * Memory comes from `Allocator` (`std::allocator<T>` by default; see also
+ * `PmrPriorityQueue`). The items array and every key array, including the
+ * handle table of an `AddressableLayout`, share a single block, so a resize
+ * is one allocation and one deallocation, and a queue can live entirely in
+ * an arena. Items are constructed through
+ * `std::allocator_traits`, so an allocator that propagates (like
+ * `std::pmr::polymorphic_allocator`) is handed on to items that take one.
+ * Assigning a queue never changes its allocator, and swapping only swaps
+ * allocators that propagate on swap; otherwise they must compare equal, as
+ * with the standard containers.
  *
  * If you're working on this implementation, be careful to use the allocator
- * correctly. That is, use `allocator.construct(arrayPtr, obj)` (not assignment)
- * to place items into empty slots in the array. Then be sure to call
- * `allocator.destroy(arrayPtr+i)` on items before deallocating the array.
- * There. I've spared you hours of confusion.
+ * correctly. That is, use `AllocTraits::construct(mAllocator, arrayPtr, obj)`
+ * (not assignment) to place items into empty slots in the array. Then be
+ * sure to call `AllocTraits::destroy(mAllocator, arrayPtr+i)` on items before
+ * deallocating the array. There. I've spared you hours of confusion.
  */
-template<class T>
+template<class T, class Priority=int,
+		 class Compare=std::greater<Priority>,
+		 class KeyLayout=TriadLayout, size_t Arity=2,
+		 class GrowthPolicy=LinearGrowth, class Allocator=allocator<T> >
 class PriorityQueue : DynamicCollectionBase {
+protected:
+	// The node machinery is protected so that other heaps on the same arrays
+	// (see MinMaxPriorityQueue.hpp) can reuse it.
+	static_assert(Arity >= 2, "A heap needs at least two children per node.");
+	static_assert(std::is_same<typename Allocator::value_type, T>::value,
+			"The allocator must allocate items.");
+	typedef HeapKeys<KeyLayout, Priority, Compare> Keys;
+	typedef allocator_traits<Allocator> AllocTraits;
+	// The block holding items and keys is allocated as bytes
+	typedef typename AllocTraits::template rebind_alloc<unsigned char>
+		BlockAllocator;
+	typedef allocator_traits<BlockAllocator> BlockTraits;
 public:
+	// Identifies an inserted item while it's in the queue.
+	// `NoHandle` unless `KeyLayout` is an `AddressableLayout`.
+	typedef typename Keys::Handle Handle;
 
 	//--------------------------------------------------------------------------
 	// INSTANTIATION / COPY SEMANTICS
@@ -72,87 +279,168 @@ public:
      * Constructs a PriorityQueue.
      *
      * @param initialCapacity - starting size of the backing data structure.
-     * @param stepSize - the size by which the size of the backing data
-     *                   structure is increased when it is full.
+     * @param growthPolicy - decides how the backing data structure grows
+     *                       when full and shrinks when sparse. With the
+     *                       default `LinearGrowth`, a plain step size works.
+     * @param alloc - allocates the backing data structure.
      */
 	PriorityQueue(size_t initialCapacity=DEFAULT_INITIAL_CAPACITY,
-				  size_t stepSize=DEFAULT_STEP_SIZE)
-		: mItemsAllocator(),
-		  mPrioritiesAllocator(),
-		  mIdsAllocator(),
+				  GrowthPolicy growthPolicy=GrowthPolicy(),
+				  const Allocator& alloc=Allocator())
+		: mAllocator(alloc),
+		  mKeys(),
+		  mGrowthPolicy(growthPolicy),
 		  mInitialCapacity(initialCapacity),
-		  mStepSize(stepSize),
-		  mStepSize2x(2*mStepSize),
+		  mMinCapacity(initialCapacity),
 		  mCapacity(mInitialCapacity),
 		  mSize(0),
+		  mNumCancelled(0),
+		  mNextId(0),
 		  mNumResizes(0)
 	{
-		// If the stepSize is zero, or the first resize would overflow size_t
-		if(stepSize == 0 || stepSize > (MAX_ID - initialCapacity)) {
-			throw out_of_range("Your `stepSize` is stupid.");
-		}
-
-		allocateArrays();
+		allocateArrays(mKeys.slotsFor(mCapacity, 0));
 
 		if(DynamicCollectionBase::DEBUG) {
 			cout << "PriorityQueue created with capacity " << initialCapacity
-				 << " and stepSize " << stepSize << endl;
+				 << endl;
 		}
 	}
 
+	/**
+	 * Constructs an empty PriorityQueue with the default capacity and growth
+	 * policy that allocates with `alloc`.
+	 *
+	 * With `PmrPriorityQueue`, a `std::pmr::memory_resource*` will do.
+	 */
+	explicit PriorityQueue(const Allocator& alloc)
+		: PriorityQueue(DEFAULT_INITIAL_CAPACITY, GrowthPolicy(), alloc)
+	{}
+
+	/**
+	 * Constructs a PriorityQueue holding the entries in `[first, last)`.
+	 *
+	 * Each entry is a `std::pair` (or `std::tuple`) of an item and its
+	 * priority. Pass move iterators to move the items in.
+	 *
+	 * This is a `~n` operation (see `insert_range()`).
+	 *
+	 * @param first, last - the range of entries to insert
+	 * @param initialCapacity - starting size of the backing data structure.
+	 *                          It grows to fit the entries if needed.
+	 * @param growthPolicy - decides how the backing data structure grows
+	 *                       when full and shrinks when sparse.
+	 * @param alloc - allocates the backing data structure.
+	 */
+	template<class InputIt, class =
+			typename std::iterator_traits<InputIt>::iterator_category>
+	PriorityQueue(InputIt first, InputIt last,
+				  size_t initialCapacity=DEFAULT_INITIAL_CAPACITY,
+				  GrowthPolicy growthPolicy=GrowthPolicy(),
+				  const Allocator& alloc=Allocator())
+		: PriorityQueue(initialCapacity, growthPolicy, alloc)
+	{
+		insert_range(first, last);
+	}
+
 	/**
 	 * Copy Constructor
 	 */
-	PriorityQueue(PriorityQueue& src)
-		: mItemsAllocator(),
-		  mPrioritiesAllocator(),
-		  mIdsAllocator(),
+	PriorityQueue(const PriorityQueue& src)
+		: PriorityQueue(src,
+				AllocTraits::select_on_container_copy_construction(
+						src.mAllocator))
+	{}
+
+	/**
+	 * Copy constructor that allocates the copy with `alloc`.
+	 */
+	PriorityQueue(const PriorityQueue& src, const Allocator& alloc)
+		: mAllocator(alloc),
+		  mKeys(),
+		  mGrowthPolicy(src.mGrowthPolicy),
 		  mInitialCapacity(src.mInitialCapacity),
+		  mMinCapacity(src.mMinCapacity),
 		  mCapacity(src.mCapacity),
 		  mSize(src.mSize),
-		  mStepSize(src.mStepSize),
-		  mStepSize2x(src.mStepSize2x),
+		  mNumCancelled(src.mNumCancelled),
+		  mNextId(src.mNextId),
 		  mNumResizes(src.mNumResizes)
 	{
-		allocateArrays();
+		allocateArrays(src.mKeys.slotsFor(mCapacity, mSize));
 
 		// Copy values
 		// arrays are related, so we can do it more efficiently than std::copy
 		for(size_t i=0; i < mSize; i++) {
-			mItems[i] = mItemsAllocator.construct(src.mItems[i]);
-			mPriorities[i] = mPrioritiesAllocator.construct(src.mPriorities[i]);
-			mIds[i] = mIdsAllocator.construct(src.mIds[i]);
+			AllocTraits::construct(mAllocator, mItems+i, src.mItems[i]);
 		}
+		mKeys.copy(src.mKeys, mSize);
 	}
 
 	/**
 	 * Copy assignment operator.
 	 *
-	 * Takes `rhs` by value, forcing a copy, then swaps.
+	 * Copies `rhs` with our allocator, then swaps.
 	 * Adapted from http://stackoverflow.com/a/3279550/1599617
 	 */
-	PriorityQueue operator=(PriorityQueue rhs) {
-		 swap(*this, rhs);
-		 return *this;
+	PriorityQueue& operator=(const PriorityQueue& rhs) {
+		if(this != &rhs) {
+			PriorityQueue copy(rhs, mAllocator);
+			swap(*this, copy);
+		}
+		return *this;
+	}
+
+	/**
+	 * Move assignment operator.
+	 *
+	 * Moves `rhs` into a queue with our allocator, then swaps.
+	 */
+	PriorityQueue& operator=(PriorityQueue&& rhs) {
+		if(this != &rhs) {
+			PriorityQueue moved(move(rhs), mAllocator);
+			swap(*this, moved);
+		}
+		return *this;
 	}
 
 	/*  Move Constructor.
 	 *
-	 * Creates default object, then swaps `src` into it, leaving `src` barren.
+	 * Creates an empty object, then swaps `src` into it, leaving `src` barren.
 	 * Adapted from http://stackoverflow.com/a/3279550/1599617
 	 */
 	PriorityQueue(PriorityQueue&& src)
-		: PriorityQueue()
+		: PriorityQueue(0, src.mGrowthPolicy, src.mAllocator)
 	{
 		swap(*this, src);
 	}
 
 	/**
-	 * Move assignment operator.
+	 * Move constructor that allocates with `alloc`.
+	 *
+	 * If `alloc` can free `src`'s memory, this swaps like the plain move
+	 * constructor. Otherwise the items are moved over one by one, and `src`
+	 * is left empty.
 	 */
-	PriorityQueue operator=(PriorityQueue&& rhs) {
-		swap(*this, rhs);
-		return *this;
+	PriorityQueue(PriorityQueue&& src, const Allocator& alloc)
+		: PriorityQueue(0, src.mGrowthPolicy, alloc)
+	{
+		if(mAllocator == src.mAllocator) {
+			swap(*this, src);
+			return;
+		}
+
+		resize(src.mCapacity, src.mKeys.slotsFor(src.mCapacity, src.mSize));
+		for(size_t i=0; i < src.mSize; i++) {
+			AllocTraits::construct(mAllocator, mItems+i, move(src.mItems[i]));
+		}
+		mKeys.copy(src.mKeys, src.mSize);
+		mInitialCapacity = src.mInitialCapacity;
+		mMinCapacity = src.mMinCapacity;
+		mSize = src.mSize;
+		mNumCancelled = src.mNumCancelled;
+		mNextId = src.mNextId;
+		mNumResizes = src.mNumResizes;
+		src.clear();
 	}
 
 	/**
@@ -165,15 +453,18 @@ public:
 		// by swapping the members of two classes,
 		// the two classes are effectively swapped
 		swap(first.mSize, second.mSize);
-		swap(first.mStepSize, second.mStepSize);
-		swap(first.mStepSize2x, second.mStepSize2x);
+		swap(first.mNumCancelled, second.mNumCancelled);
+		swap(first.mGrowthPolicy, second.mGrowthPolicy);
 		swap(first.mInitialCapacity, second.mInitialCapacity);
+		swap(first.mMinCapacity, second.mMinCapacity);
+		swapAllocators(first.mAllocator, second.mAllocator,
+				typename AllocTraits::propagate_on_container_swap());
+		swap(first.mBlock, second.mBlock);
 		swap(first.mItems, second.mItems);
-		swap(first.mPriorities, second.mPriorities);
-		swap(first.mItemsAllocator, second.mItemsAllocator);
-		swap(first.mPrioritiesAllocator, second.mPrioritiesAllocator);
-		swap(first.mIdsAllocator, second.mIdsAllocator);
+		swap(first.mKeys, second.mKeys);
 		swap(first.mCapacity, second.mCapacity);
+		swap(first.mNextId, second.mNextId);
+		swap(first.mNumResizes, second.mNumResizes);
 	}
 
 	/// Destructor
@@ -195,32 +486,115 @@ public:
 	 * This is a `~log n` operation unless the backing data structure
 	 * needs to be resized.
 	 *
-	 * @param item - the item to insert (copied by value)
+	 * @param item - the item to insert (copied)
 	 * @param score - the priority of this item
+	 * @return a handle to the item (see `update()`)
 	 */
-	void insert(T item, int score) {
-		// If we're full, resize up
-		if(mSize == mCapacity) {
-			resize(mCapacity + mStepSize);
-		}
+	Handle insert(const T& item, const Priority& score) {
+		return emplace(score, item);
+	}
 
-		// Consolidate ids if necessary (rare occurrence)
-		checkIdOverflow();
+	/**
+	 * Inserts `item` of type `T` with priority `score`, moving from `item`.
+	 *
+	 * @param item - the item to insert (moved)
+	 * @param score - the priority of this item
+	 * @return a handle to the item (see `update()`)
+	 */
+	Handle insert(T&& item, const Priority& score) {
+		return emplace(score, move(item));
+	}
 
+	/**
+	 * Constructs an item of type `T` in place from `args` and inserts it
+	 * with priority `score`.
+	 *
+	 * @param score - the priority of the new item
+	 * @param args - arguments forwarded to the constructor of `T`
+	 * @return a handle to the item (see `update()`)
+	 */
+	template<class... Args>
+	Handle emplace(const Priority& score, Args&&... args) {
 		// Insert the item at the end and swim it up to it's place
-		size_t i = mSize;
-		createNode(i, item, score, mNextId);
-		mNextId++;
-		mSize++;
-		swim(i);
+		return mKeys.handle(swim(emplaceBack(score, forward<Args>(args)...)));
+	}
+
+	/**
+	 * Inserts the entries in `[first, last)`.
+	 *
+	 * Each entry is a `std::pair` (or `std::tuple`) of an item and its
+	 * priority. Pass move iterators to move the items in. Insertion ids
+	 * are assigned in input order, so ties still leave first-in, first-out.
+	 * No handles are returned.
+	 *
+	 * The entries are appended in bulk (with at most one resize, given
+	 * forward iterators) and the heap is then repaired bottom-up, Floyd
+	 * style, visiting only the new nodes and their ancestors. Inserting
+	 * `m` entries into a queue of `n` is a `~(n + m)` operation at worst,
+	 * and closer to `~m` when `m` is small, versus `~m log(n + m)` for
+	 * repeated `insert()`.
+	 *
+	 * @param first, last - the range of entries to insert
+	 */
+	template<class InputIt>
+	void insert_range(InputIt first, InputIt last) {
+		size_t begin = mSize;
+		appendRange(first, last,
+				typename std::iterator_traits<InputIt>::iterator_category());
+		heapifyFrom(begin);
+	}
+
+	/**
+	 * Moves every item of `other` into this queue, leaving `other` empty.
+	 *
+	 * The items are appended in bulk, with at most one resize, and the heap
+	 * is repaired as in `insert_range()`: `~(n + m)` instead of the
+	 * `~m log(n + m)` of popping `other` into this queue.
+	 *
+	 * Insertion order is kept across the two queues. `other`'s ids are
+	 * offset past ours, as if its items had been inserted after all of ours
+	 * (in their original order), so ties still leave first-in, first-out
+	 * within each queue and ours leave first. Handles into `other` are
+	 * invalidated; the moved items get new ones.
+	 *
+	 * @param other - the queue to empty into this one
+	 */
+	void merge(PriorityQueue&& other) {
+		if(&other == this || other.empty()) {
+			return;
+		}
+		// Cancelled nodes would be live again in a new place
+		other.removeCancelled();
+
+		// Make room for `other`'s ids after ours
+		if(other.mNextId > Keys::MAX_ID - mNextId) {
+			compactIds();
+			other.compactIds();
+			if(other.mNextId > Keys::MAX_ID - mNextId) {
+				throw length_error(
+						"PriorityQueue has run out of insertion ids.");
+			}
+		}
+
+		size_t begin = mSize;
+		makeRoom(other.mSize);
+		for(size_t j = 0; j < other.mSize; j++) {
+			createNode(mSize, other.mKeys.priority(j),
+					mNextId + other.mKeys.id(j), move(other.mItems[j]));
+			mSize++;
+		}
+		mNextId += other.mNextId;
+		other.clear();
+		heapifyFrom(begin);
 	}
 
 	/**
 	 * Returns a constant reference to the element with the highest priority.
 	 *
-	 * The highest priority is given to the item with the highest insertion
-	 * `score` and the earliest insertion id. That is, ties are broken by a
-	 * FIFO policy.
+	 * The highest priority is given to the item whose insertion `score`
+	 * comes first according to `Compare`. Unless the key layout is
+	 * `UnstableLayout`, ties go to the earliest insertion id. That is,
+	 * ties are broken by a FIFO policy.
 	 *
 	 * This is a constant time operation.
 	 *
@@ -230,6 +604,15 @@ public:
 		return mItems[0];
 	}
 
+	/**
+	 * Returns the priority of the element with the highest priority.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	Priority getTopPriority() const {
+		return mKeys.priority(0);
+	}
+
 	/**
 	 * Removes (and destroys) the element with the highest priority.
 	 *
@@ -237,30 +620,234 @@ public:
 	 * a copy. Since the removed element is destroyed, it's best to use raw
 	 * or smart pointers.
 	 *
-	 * If `getSize() < getCapacity() - 2*stepSize` at the time of removal,
-	 * a resize operation will occur to shrink the backing data structure.
+	 * If the growth policy decides the backing data structure is too sparse
+	 * at the time of removal, a resize operation will occur to shrink it.
 	 *
 	 * This is a `~2log n` operation unless the backing data structure needs to
 	 * be resized.
 	 */
 	void pop() {
 		if(!empty()) {
-			// Swap the root with the last element
-			swapNodes(0, mSize - 1);
-			destroyNode(mSize-1);
-			mSize--;
+			removeNode(0);
+			dropCancelledTop();
 
 			// Check if we need to resize
 			checkCapacity();
+		}
+	}
 
-			// And sink the new root to it's proper place.
-			sink(0);
+	/**
+	 * Removes up to `k` elements in priority order, moving each one to `out`.
+	 *
+	 * This is like `k` calls to `pop_value()`, but the backing data
+	 * structure is only checked for shrinking once, after the whole batch.
+	 *
+	 * @param k - the maximum number of elements to remove
+	 * @param out - an output iterator to move the elements to
+	 * @return `out`, advanced past the last element written
+	 */
+	template<class OutputIt>
+	OutputIt pop_n(size_t k, OutputIt out) {
+		for(; k > 0 && !empty(); k--) {
+			*out = move(mItems[0]);
+			++out;
+			removeNode(0);
+			dropCancelledTop();
+		}
+		checkCapacity();
+		return out;
+	}
+
+	/**
+	 * Removes all elements in priority order, moving each one to `out`.
+	 *
+	 * Cancelled items are removed, and the queue is heapsorted in place
+	 * first: the root is repeatedly
+	 * swapped to the end of a shrinking heap, leaving the items in reverse
+	 * priority order. They're then moved out from the back, and the
+	 * backing data structure is shrunk once.
+	 *
+	 * If writing to `out` throws, the remaining elements are destroyed and
+	 * the queue is left empty.
+	 *
+	 * @param out - an output iterator to move the elements to
+	 * @return `out`, advanced past the last element written
+	 */
+	template<class OutputIt>
+	OutputIt drain(OutputIt out) {
+		removeCancelled();
+		heapsort();
+		return drainSorted(out, true);
+	}
+
+	/**
+	 * Removes all elements in reverse priority order (lowest first), moving
+	 * each one to `out`.
+	 *
+	 * Works like `drain()`, moving the heapsorted items out from the front.
+	 *
+	 * @param out - an output iterator to move the elements to
+	 * @return `out`, advanced past the last element written
+	 */
+	template<class OutputIt>
+	OutputIt drain_reverse(OutputIt out) {
+		removeCancelled();
+		heapsort();
+		return drainSorted(out, false);
+	}
+
+	/**
+	 * Removes the element with the highest priority and returns it.
+	 *
+	 * The element is moved out rather than copied, so this is the cheapest
+	 * way to take ownership of the top element.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	T pop_value() {
+		T item(move(mItems[0]));
+		pop();
+		return item;
+	}
+
+	/**
+	 * Replaces the element with the highest priority by `item` with
+	 * priority `score`.
+	 *
+	 * This is a single `~log n` sink, about half the work of a `pop()`
+	 * followed by an `insert()`.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 *
+	 * @param item - the item to insert (copied)
+	 * @param score - the priority of this item
+	 * @return a handle to the item (see `update()`)
+	 */
+	Handle replace_top(const T& item, const Priority& score) {
+		return emplace_top(score, item);
+	}
+
+	/**
+	 * Replaces the element with the highest priority by `item` with
+	 * priority `score`, moving from `item`.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 *
+	 * @param item - the item to insert (moved)
+	 * @param score - the priority of this item
+	 * @return a handle to the item (see `update()`)
+	 */
+	Handle replace_top(T&& item, const Priority& score) {
+		return emplace_top(score, move(item));
+	}
+
+	/**
+	 * Replaces the element with the highest priority by an item of type `T`
+	 * constructed from `args`, with priority `score`.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 *
+	 * @param score - the priority of the new item
+	 * @param args - arguments forwarded to the constructor of `T`
+	 * @return a handle to the item (see `update()`)
+	 */
+	template<class... Args>
+	Handle emplace_top(const Priority& score, Args&&... args) {
+		checkIdOverflow();
+
+		// `args` may refer to the top item, so build the new one first
+		T item(forward<Args>(args)...);
+		mItems[0] = move(item);
+		mKeys.destroy(0);
+		mKeys.construct(0, score, mNextId);
+		mNextId++;
+		Handle handle = mKeys.handle(sink(0));
+		dropCancelledTop();
+		return handle;
+	}
 
-			// We do all this to avoid the alternative -- a ~n remove that shifts
-			// all the elements in the array up.
+	/**
+	 * Changes the priority of the item with `handle` to `score`.
+	 *
+	 * The item moves up or down to its new place. Its insertion id is kept,
+	 * so among equal priorities it's still ordered by when it was inserted.
+	 *
+	 * This is a `~log n` operation. It needs an `AddressableLayout`.
+	 *
+	 * @param handle - the handle `insert()` returned for the item
+	 * @param score - the new priority of the item
+	 * @throws out_of_range if the item is no longer in the queue
+	 */
+	void update(Handle handle, const Priority& score) {
+		size_t i = positionOf(handle);
+		mKeys.setPriority(i, score);
+		reposition(i);
+		dropCancelledTop();
+	}
+
+	/**
+	 * Removes (and destroys) the item with `handle`.
+	 *
+	 * This is a `~log n` operation unless the backing data structure needs
+	 * to be resized. It needs an `AddressableLayout`.
+	 *
+	 * @param handle - the handle `insert()` returned for the item
+	 * @throws out_of_range if the item is no longer in the queue
+	 */
+	void erase(Handle handle) {
+		removeNode(positionOf(handle));
+		dropCancelledTop();
+		checkCapacity();
+	}
+
+	/**
+	 * Cancels the item with `handle`: it's marked dead but left in place,
+	 * and destroyed later, when it reaches the top or the queue compacts.
+	 *
+	 * This is a constant time operation, where `erase()` is `~log n`. It
+	 * pays off when most cancelled items would never have reached the top.
+	 * `top()` and `pop()` never see cancelled items, `getSize()` doesn't
+	 * count them, and `contains()` is false for them. Once more than a
+	 * quarter of the nodes are cancelled, they're all removed in one `~n`
+	 * pass. Compacting that early costs a few moves per cancelled item,
+	 * which is cheaper than popping dead nodes off the top later. It needs
+	 * an `AddressableLayout`.
+	 *
+	 * @param handle - the handle `insert()` returned for the item
+	 * @throws out_of_range if the item is no longer in the queue
+	 */
+	void cancel(Handle handle) {
+		mKeys.cancel(positionOf(handle));
+		mNumCancelled++;
+		if(4*mNumCancelled > mSize) {
+			compact();
+		} else {
+			dropCancelledTop();
+			checkCapacity();
 		}
 	}
 
+	/**
+	 * Returns true if the item with `handle` is still in the queue.
+	 *
+	 * Once the item has left the queue (or been cancelled), its handle never
+	 * finds anything again, even after later insertions reuse its slot.
+	 * It needs an `AddressableLayout`.
+	 */
+	bool contains(Handle handle) const {
+		return mKeys.position(handle) != Keys::NOT_IN_HEAP;
+	}
+
+	/**
+	 * Returns the priority of the item with `handle`.
+	 * It needs an `AddressableLayout`.
+	 *
+	 * @throws out_of_range if the item is no longer in the queue
+	 */
+	Priority getPriority(Handle handle) const {
+		return mKeys.priority(positionOf(handle));
+	}
+
 	/**
 	 * Returns true if container is empty.
 	 */
@@ -274,14 +861,43 @@ public:
 	void clear() {
 		destroyAllNodes();
 		mSize = 0;
-		resize(mInitialCapacity);
+		mNumCancelled = 0;
+		resize(mMinCapacity);
 	}
 
 	/**
-	 * Returns the number of elements in the container.
+	 * Ensures the backing data structure can hold at least `capacity` items
+	 * without resizing.
+	 *
+	 * Reserved capacity is never given back by automatic shrinking.
+	 * Call `shrink_to_fit()` to release it.
+	 */
+	void reserve(size_t capacity) {
+		if(capacity > mMinCapacity) {
+			mMinCapacity = capacity;
+		}
+		if(capacity > mCapacity) {
+			resize(capacity);
+		}
+	}
+
+	/**
+	 * Releases any reservation and shrinks the backing data structure to
+	 * exactly `getSize()` items.
+	 */
+	void shrink_to_fit() {
+		mMinCapacity = mInitialCapacity;
+		if(mSize < mCapacity) {
+			resize(mSize);
+		}
+	}
+
+	/**
+	 * Returns the number of elements in the container, not counting
+	 * cancelled ones.
 	 */
 	const size_t getSize() const{
-		return mSize;
+		return mSize - mNumCancelled;
 	}
 
 	/**
@@ -297,21 +913,28 @@ public:
 	const int getNumResizes() const {
 		return mNumResizes;
 	}
-private:
-	// Using multiple arrays instead of an array of node container objects
-	// cuts down on memory allocations.
+
+	/**
+	 * Returns a copy of the allocator.
+	 */
+	Allocator getAllocator() const {
+		return mAllocator;
+	}
+protected:
+	Allocator mAllocator;
+	// One allocation holds the items array and the key arrays. Keeping the
+	// items apart from the keys means comparisons while sifting only touch
+	// the (small) keys.
+	unsigned char* mBlock;
 	T* mItems;
-	allocator<T> mItemsAllocator;
-	int* mPriorities;
-	allocator<int> mPrioritiesAllocator;
-	size_t* mIds;
-	allocator<size_t> mIdsAllocator;
+	Keys mKeys;
 
+	GrowthPolicy mGrowthPolicy;
 	size_t mInitialCapacity;
-	size_t mStepSize;
-	size_t mStepSize2x; // cache this for performance
+	size_t mMinCapacity; // automatic shrinking stops here
 	size_t mCapacity;
-	size_t mSize;
+	size_t mSize; // nodes in the arrays, cancelled ones included
+	size_t mNumCancelled; // cancelled nodes not yet removed
 	size_t mNextId; // the id of the next inserted item
 	int mNumResizes;
 
@@ -321,22 +944,76 @@ private:
 
 	/**
 	 * Allocate the backing arrays.
+	 *
+	 * @param numSlots - the size of the handle table, if there is one
 	 */
-	void allocateArrays() {
-		mItems = mItemsAllocator.allocate(mCapacity);
-		mPriorities = mPrioritiesAllocator.allocate(mCapacity);
-		mIds = mIdsAllocator.allocate(mCapacity);
+	void allocateArrays(size_t numSlots) {
+		mBlock = allocateBlock(mCapacity, numSlots, mItems, mKeys);
 	}
 
 	/**
 	 * Deallocate the backing arrays.
 	 */
 	void deallocateArrays() {
-		mItemsAllocator.deallocate(mItems, mCapacity);
-		mPrioritiesAllocator.deallocate(mPriorities, mCapacity);
-		mIdsAllocator.deallocate(mIds, mCapacity);
+		BlockAllocator blockAllocator(mAllocator);
+		BlockTraits::deallocate(blockAllocator, mBlock,
+				blockSize(mCapacity, mKeys.getNumSlots()));
+	}
+
+	/**
+	 * Allocates one block for `capacity` nodes and carves the items array
+	 * and the key arrays out of it.
+	 *
+	 * @param capacity - the number of nodes the block must hold
+	 * @param numSlots - the size of the handle table, if there is one
+	 * @param items - set to the (uninitialized) items array
+	 * @param keys - pointed at their arrays in the block
+	 * @return the block, to deallocate later
+	 */
+	unsigned char* allocateBlock(size_t capacity, size_t numSlots, T*& items,
+			Keys& keys) {
+		BlockAllocator blockAllocator(mAllocator);
+		unsigned char* block = BlockTraits::allocate(blockAllocator,
+				blockSize(capacity, numSlots));
+		unsigned char* cursor = block;
+		keys.place(cursor, capacity);
+		keys.placeSlots(cursor, numSlots);
+		items = carve<T>(cursor, capacity);
+		return block;
 	}
 
+	/**
+	 * Returns the size in bytes of the block for `capacity` nodes and a
+	 * handle table of `numSlots` slots.
+	 */
+	static size_t blockSize(size_t capacity, size_t numSlots) {
+		size_t fixed = Keys::storageSize(0) + Keys::slotStorageSize(0)
+				+ carvedSize<T>(0);
+		size_t perNode = Keys::storageSize(1) + carvedSize<T>(1)
+				- Keys::storageSize(0) - carvedSize<T>(0);
+		size_t perSlot = Keys::slotStorageSize(1) - Keys::slotStorageSize(0);
+		size_t max = DynamicCollectionBase::MAX_ID - fixed;
+		if(capacity > max / perNode || (perSlot > 0
+				&& numSlots > (max - capacity * perNode) / perSlot)) {
+			throw length_error("PriorityQueue capacity would overflow.");
+		}
+		return fixed + capacity * perNode + numSlots * perSlot;
+	}
+
+	/**
+	 * Swaps `a` and `b`, which propagate on swap.
+	 */
+	static void swapAllocators(Allocator& a, Allocator& b, std::true_type) {
+		using std::swap;
+		swap(a, b);
+	}
+
+	/**
+	 * Leaves `a` and `b` alone: they don't propagate on swap, so they're
+	 * equal.
+	 */
+	static void swapAllocators(Allocator&, Allocator&, std::false_type) {}
+
 	/**
 	 * Destroy all objects associated with all nodes.
 	 */
@@ -348,11 +1025,11 @@ private:
 
 	/**
 	 * Destroys all objects associated with node `i`
+	 * (Keys are trivially destructible, but may need to release a handle.)
 	 */
 	void destroyNode(size_t i) {
-		mItemsAllocator.destroy(mItems+i);
-		mPrioritiesAllocator.destroy(mPriorities+i);
-		mIdsAllocator.destroy(mIds+i);
+		AllocTraits::destroy(mAllocator, mItems+i);
+		mKeys.destroy(i);
 	}
 
 	/**
@@ -362,14 +1039,252 @@ private:
 	 * has not been destroyed.
 	 *
 	 * @param i - the index of the new node
-	 * @param item - the item stored by the node
 	 * @param priority - the priority of the node
 	 * @param id - the insertion id of the node
+	 * @param args - arguments forwarded to the constructor of the item
+	 */
+	template<class... Args>
+	void createNode(size_t i, const Priority& priority, size_t id,
+			Args&&... args) {
+		AllocTraits::construct(mAllocator, mItems+i, forward<Args>(args)...);
+		mKeys.construct(i, priority, id);
+	}
+
+	/**
+	 * Creates a new node at the end of the arrays, growing them if they're
+	 * full, without restoring heap order.
+	 *
+	 * @param score - the priority of the new node
+	 * @param args - arguments forwarded to the constructor of the item
+	 * @return the index of the new node
+	 */
+	template<class... Args>
+	size_t emplaceBack(const Priority& score, Args&&... args) {
+		// Consolidate ids if necessary (rare occurrence)
+		checkIdOverflow();
+
+		size_t i = mSize;
+		if(mSize == mCapacity) {
+			// `args` may refer to an item we're about to relocate,
+			// so build the new item before resizing up.
+			T item(forward<Args>(args)...);
+			resize(mGrowthPolicy.grow(mCapacity));
+			createNode(i, score, mNextId, move(item));
+		} else {
+			createNode(i, score, mNextId, forward<Args>(args)...);
+		}
+		mNextId++;
+		mSize++;
+		return i;
+	}
+
+	/**
+	 * Removes (and destroys) node `i` without checking capacity.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	void removeNode(size_t i) {
+		// Replace the node with the last element,
+		// and move the replacement to it's proper place.
+		if(unlinkNode(i)) {
+			reposition(i);
+		}
+
+		// We do all this to avoid the alternative -- a ~n remove that shifts
+		// all the elements in the array up.
+	}
+
+	/**
+	 * Removes cancelled nodes from the top until a live one is there, so
+	 * `top()` never sees one, without checking capacity.
+	 */
+	void dropCancelledTop() {
+		while(mNumCancelled > 0 && mKeys.cancelled(0)) {
+			removeNode(0);
+			mNumCancelled--;
+		}
+	}
+
+	/**
+	 * Removes (and destroys) all cancelled nodes, like `removeCancelled()`,
+	 * then shrinks the backing data structure if the growth policy says so.
+	 */
+	void compact() {
+		if(mNumCancelled > 0) {
+			removeCancelled();
+			checkCapacity();
+		}
+	}
+
+	/**
+	 * Removes (and destroys) all cancelled nodes in one `~n` pass: live
+	 * nodes slide down over them and the heap is rebuilt bottom-up. The
+	 * capacity is left alone, for callers that shrink later anyway.
+	 */
+	void removeCancelled() {
+		if(mNumCancelled == 0) {
+			return;
+		}
+
+		size_t live = 0;
+		for(size_t i = 0; i < mSize; i++) {
+			if(mKeys.cancelled(i)) {
+				destroyNode(i);
+				continue;
+			}
+			if(live < i) {
+				// Slot `live` was destroyed, so construct rather than assign
+				AllocTraits::construct(mAllocator, mItems+live,
+						move(mItems[i]));
+				AllocTraits::destroy(mAllocator, mItems+i);
+				mKeys.move(i, live);
+			}
+			live++;
+		}
+		mSize = live;
+		mNumCancelled = 0;
+		rebuildHeap();
+	}
+
+	/**
+	 * Removes (and destroys) node `i` by moving the last node into its
+	 * place, without restoring heap order or checking capacity.
+	 *
+	 * @return true if a node was moved to `i`
+	 */
+	bool unlinkNode(size_t i) {
+		mKeys.destroy(i);
+		size_t last = mSize - 1;
+		if(i < last) {
+			moveNode(last, i);
+		}
+		AllocTraits::destroy(mAllocator, mItems+last);
+		mSize--;
+		return i < mSize;
+	}
+
+	/**
+	 * Returns the index of the node with `handle`.
+	 *
+	 * @throws out_of_range if there's no such node
+	 */
+	size_t positionOf(Handle handle) const {
+		static_assert(!std::is_same<Handle, NoHandle>::value,
+				"Handles need an AddressableLayout.");
+		size_t i = mKeys.position(handle);
+		if(i == Keys::NOT_IN_HEAP) {
+			throw out_of_range("That item is no longer in the PriorityQueue.");
+		}
+		return i;
+	}
+
+	/**
+	 * Creates a new node at the end of the arrays from `entry`, a pair or
+	 * tuple of an item and its priority, without restoring heap order.
+	 *
+	 * The caller makes sure there's room.
+	 */
+	template<class Entry>
+	void appendNode(Entry&& entry) {
+		using std::get;
+		checkIdOverflow();
+		createNode(mSize, get<1>(entry), mNextId,
+				get<0>(forward<Entry>(entry)));
+		mNextId++;
+		mSize++;
+	}
+
+	/**
+	 * Appends `[first, last)`, growing once to fit them all.
+	 */
+	template<class ForwardIt>
+	void appendRange(ForwardIt first, ForwardIt last,
+					 std::forward_iterator_tag) {
+		makeRoom(std::distance(first, last));
+		for(; first != last; ++first) {
+			appendNode(*first);
+		}
+	}
+
+	/**
+	 * Grows once, if needed, to fit `count` more nodes.
+	 */
+	void makeRoom(size_t count) {
+		if(count > mCapacity - mSize) {
+			// Grow at least as much as the policy would have
+			size_t newCapacity = mGrowthPolicy.grow(mCapacity);
+			if(count > DynamicCollectionBase::MAX_ID - mSize) {
+				throw length_error("PriorityQueue capacity would overflow.");
+			}
+			if(newCapacity < mSize + count) {
+				newCapacity = mSize + count;
+			}
+			resize(newCapacity);
+		}
+	}
+
+	/**
+	 * Appends `[first, last)`, growing as needed.
+	 */
+	template<class InputIt>
+	void appendRange(InputIt first, InputIt last, std::input_iterator_tag) {
+		for(; first != last; ++first) {
+			if(mSize == mCapacity) {
+				resize(mGrowthPolicy.grow(mCapacity));
+			}
+			appendNode(*first);
+		}
+	}
+
+	/**
+	 * Heapsorts the nodes in place: the root is repeatedly swapped to the
+	 * end of a shrinking heap, leaving them in reverse priority order.
+	 * The nodes are no longer a heap afterwards.
+	 */
+	void heapsort() {
+		size_t size = mSize;
+		while(mSize > 1) {
+			swapNodes(0, mSize - 1);
+			mSize--;
+			sink(0);
+		}
+		mSize = size;
+	}
+
+	/**
+	 * Moves heapsorted items to `out`, from the back (highest priority
+	 * first) if `fromBack` or else from the front, then empties the queue
+	 * and shrinks it once.
+	 *
+	 * If writing to `out` throws, the remaining elements are destroyed and
+	 * the queue is left empty.
 	 */
-	void createNode(size_t i, T item, int priority, size_t id) {
-		mItemsAllocator.construct(mItems+i, item);
-		mPrioritiesAllocator.construct(mPriorities+i, priority);
-		mIdsAllocator.construct(mIds+i, id);
+	template<class OutputIt>
+	OutputIt drainSorted(OutputIt out, bool fromBack) {
+		try {
+			for(size_t n = 0; n < mSize; n++) {
+				*out = move(mItems[fromBack ? mSize - 1 - n : n]);
+				++out;
+			}
+		} catch(...) {
+			destroyAllNodes();
+			mSize = 0;
+			checkCapacity();
+			throw;
+		}
+
+		destroyAllNodes();
+		mSize = 0;
+		checkCapacity();
+		return out;
+	}
+
+	/**
+	 * Move-assigns node `src` onto the live node `dest` across all arrays.
+	 */
+	void moveNode(size_t src, size_t dest) {
+		mItems[dest] = move(mItems[src]);
+		mKeys.move(src, dest);
 	}
 
 	/**
@@ -377,55 +1292,79 @@ private:
 	 */
 	void swapNodes(size_t a, size_t b) {
 		swap(mItems[a], mItems[b]);
-		swap(mPriorities[a], mPriorities[b]);
-		swap(mIds[a], mIds[b]);
+		mKeys.swap(a, b);
 	}
 
 	/**
 	 * Check whether or not the backing structure(s) need to be sized down.
 	 */
 	void checkCapacity() {
-		// remember size_t is unsigned
-		// If we've shrunk enough, resize down to free memory
-		if(mCapacity >= mStepSize2x && mSize < (mCapacity - mStepSize2x)) {
-
-			//cout << mSize << " is less than " << (mCapacity - mStepSize2x) << endl;
-
-			// Compute ideal newCapacity
-			size_t newCapacity = mCapacity - mStepSize;
-			//cout << "idealCapacity: " << newCapacity << endl;
+		// Ask the policy for the ideal capacity. After a batch of removals
+		// it may want to shrink several steps, so follow it all the way
+		// down and resize once.
+		size_t newCapacity = mCapacity;
+		size_t nextCapacity = mGrowthPolicy.shrink(newCapacity, mSize);
+		while(nextCapacity < newCapacity && nextCapacity >= mMinCapacity) {
+			newCapacity = nextCapacity;
+			nextCapacity = mGrowthPolicy.shrink(newCapacity, mSize);
+		}
 
-			if(newCapacity >= mInitialCapacity) {
-				resize(newCapacity);
-			}
+		if(newCapacity < mCapacity) {
+			resize(newCapacity);
 		}
 	}
 
 	/**
 	 * Since `nextId` increases over the lifetime of the queue,
 	 * irrespective of the current number of elements, it's possible for
-	 * `nextId` to overflow. However, there will never be more than the
-	 * max value of size_t elements in the queue, so we can consolidate
-	 * ids in the event of an impending overflow.
+	 * `nextId` to overflow the ids the key layout can store. However,
+	 * there will rarely be that many elements in the queue, so we can
+	 * consolidate ids in the event of an impending overflow.
+	 *
+	 * @throws length_error only if the queue already holds `MAX_ID` items
 	 */
 	void checkIdOverflow() {
 		// If the next increment of `nextId` would overflow
-		// and we can consolidate
-		if(mNextId == MAX_ID && mSize < MAX_ID) {
+		if(mNextId == Keys::MAX_ID) {
+			if(mSize >= Keys::MAX_ID) {
+				throw length_error(
+						"PriorityQueue has run out of insertion ids.");
+			}
 			consolidateIds();
 		}
 	}
 
 	/**
-	 * Consolidates the ids for all nodes into the range [0, mSize).
+	 * Frees up ids, preserving their relative order.
+	 * See `consolidateNodeIds()`.
 	 */
 	void consolidateIds() {
-		// TODO efficiently sort pointers to items in mIds in an aux array
-		// then iterate through aux and assign 0 <= i < mSize
-		// I don't have time to do this right now. It's an edge case anyway.
-		throw runtime_error(
-				string("PriorityQueue::consolidateIds() has been left") +
-				string(" as an exercise to the reader.") );
+		auto swapper = [this](size_t a, size_t b) { swapNodes(a, b); };
+		if(consolidateNodeIds(mKeys, mSize, mNextId, swapper)) {
+			rebuildHeap();
+		}
+	}
+
+	/**
+	 * Renumbers the ids of all nodes into the range [0, mSize), preserving
+	 * their relative order, and puts them back in heap order bottom-up.
+	 * See `compactNodeIds()`.
+	 */
+	void compactIds() {
+		compactNodeIds(mKeys, mSize,
+				[this](size_t a, size_t b) { swapNodes(a, b); });
+		mNextId = mSize;
+		rebuildHeap();
+	}
+
+	/**
+	 * Puts all the nodes back in heap order, after `compactIds()` sorted
+	 * them by id.
+	 *
+	 * Other heaps built on these arrays override this with their own order.
+	 */
+	virtual void rebuildHeap() {
+		heapifyFrom(0);
 	}
 
 	/**
@@ -437,7 +1376,7 @@ private:
 		cout << "Array contents: " << endl;
 				for (size_t i = 0; i < mSize; i++) {
 				    cout << "\t #" << i << ": "
-				    	 << mItems[i] << "/" << mPriorities[i] << endl;
+				    	 << mItems[i] << "/" << mKeys.priority(i) << endl;
 				}
 	}
 
@@ -447,6 +1386,16 @@ private:
 	 * @param newCapacity - the capacity to resize to
 	 */
 	void resize(size_t newCapacity) {
+		resize(newCapacity, mKeys.slotsFor(newCapacity, mSize));
+	}
+
+	/**
+	 * Resizes the backing array, with a handle table of `numSlots` slots.
+	 *
+	 * @param newCapacity - the capacity to resize to
+	 * @param numSlots - the size of the handle table, if there is one
+	 */
+	void resize(size_t newCapacity, size_t numSlots) {
 
 		if(DynamicCollectionBase::DEBUG) {
 			cout << "RESIZING from " << mCapacity << " to " << newCapacity
@@ -454,56 +1403,81 @@ private:
 		}
 
 		// Allocate new arrays
-		T* newItems = mItemsAllocator.allocate(newCapacity);
-		int* newPriorities = mPrioritiesAllocator.allocate(newCapacity);
-		size_t* newIds = mIdsAllocator.allocate(newCapacity);
+		T* newItems;
+		Keys newKeys;
+		unsigned char* newBlock =
+				allocateBlock(newCapacity, numSlots, newItems, newKeys);
 
-		// Copy values to new array and destroy original values.
-		for(size_t i=0; i < mSize; i++) {
-			mItemsAllocator.construct(newItems+i,mItems[i]);
-			mPrioritiesAllocator.construct(newPriorities+i,mPriorities[i]);
-			mIdsAllocator.construct(newIds+i, mIds[i]);
-			destroyNode(i);
-		}
+		// Relocate values to new array.
+		// Keys are trivial, so they can always be memcpy'd.
+		relocateItems(newItems, mItems, IsTriviallyRelocatable<T>());
+		mKeys.relocate(newKeys, mSize);
 
 		// Deallocate old arrays
 		deallocateArrays();
 
 		// update pointers to new arrays
+		mBlock = newBlock;
 		mItems = newItems;
-		mPriorities = newPriorities;
-		mIds = newIds;
+		swap(mKeys, newKeys);
 		mCapacity = newCapacity;
 
 		mNumResizes++;
 	}
 
+	/**
+	 * Relocates all items from `src` into the uninitialized array `dest`
+	 * with a single `memcpy`. The originals are left for deallocation.
+	 */
+	void relocateItems(T* dest, T* src, std::true_type) {
+		if(mSize > 0) {
+			memcpy(static_cast<void*>(dest), src, mSize*sizeof(T));
+		}
+	}
+
+	/**
+	 * Relocates all items from `src` into the uninitialized array `dest`
+	 * by moving (or copying, if moving might throw) and destroying each one.
+	 */
+	void relocateItems(T* dest, T* src, std::false_type) {
+		for(size_t i=0; i < mSize; i++) {
+			AllocTraits::construct(mAllocator, dest+i, move_if_noexcept(src[i]));
+			AllocTraits::destroy(mAllocator, src+i);
+		}
+	}
+
 	/**
 	 * Propagates a node **downward** to its proper place to reheapify the heap.
 	 *
 	 * @param i - the current index of the node to sink
+	 * @return the new index of the node
 	 */
-	void sink(size_t i) {
+	size_t sink(size_t i) {
 		bool heapified = false;
 		while(!heapified) { // While node `i` is out of place
 
 			// Assume node is correctly placed
 			size_t destIdx = i;
 
-			// Get child indexes
-			size_t leftIdx = leftIdxOf(i);
-			size_t rightIdx = rightIdxOf(i);
-
-			// If the right child has greater priority
-			if(greaterPriority(rightIdx, leftIdx)) {
-				destIdx = rightIdx;
-			} else if(greaterPriority(leftIdx, rightIdx)) {
-				// if the left child has greater priority
-				destIdx = leftIdx;
+			// Get the range of child indexes
+			size_t firstIdx = firstChildIdxOf(i);
+			if(firstIdx < mSize) {
+				size_t endIdx =
+						(mSize - firstIdx > Arity) ? firstIdx + Arity : mSize;
+
+				// Pick the child with greatest priority
+				// (Siblings share a cache line, so this scan is cheap, and
+				// may be vectorized; see SiblingSelect.hpp.)
+				size_t childIdx = SiblingSelect<Arity, Keys>::best(mKeys,
+						firstIdx, endIdx - firstIdx);
+
+				// If that child has greater priority than `i`
+				if(greaterPriority(childIdx, i)) {
+					destIdx = childIdx;
+				}
 			}
 
 			// If `i` has greatest priority (or `i` is a leaf)
-			// (Remember leaf nodes return their own index for child indices)
 			if(destIdx == i) {
 				heapified = true;
 			} else {
@@ -511,14 +1485,61 @@ private:
 				i = destIdx;
 			}
 		}
+		return i;
+	}
+
+	/**
+	 * Restores heap order after unordered nodes were appended at `begin`
+	 * onwards, assuming the nodes before `begin` form a heap.
+	 *
+	 * This is Floyd's bottom-up heap construction, restricted to the nodes
+	 * whose subtrees changed: the ancestors of the new nodes. At each level
+	 * those are a contiguous range of indexes, so we sink them range by
+	 * range, from the bottom up, in decreasing index order. (With
+	 * `begin == 0` that's plain Floyd over the whole heap.)
+	 *
+	 * That still sinks every ancestor, about `log n` of them for even one
+	 * new node, while swimming a node up usually stops after a level or two.
+	 * So up to `log n` new nodes are swum up one by one instead.
+	 *
+	 * @param begin - the index of the first appended node
+	 */
+	void heapifyFrom(size_t begin) {
+		if(begin >= mSize || mSize < 2) {
+			return;
+		}
+		if(begin > 0 && mSize - begin <= highestBit(mSize)) {
+			for(size_t i = begin; i < mSize; i++) {
+				swim(i);
+			}
+			return;
+		}
+
+		size_t lo = parentIdxOf(begin);
+		size_t hi = parentIdxOf(mSize - 1);
+		size_t end = hi + 1; // nodes at `end` and above are done
+		while(true) {
+			// Ranges on consecutive levels can overlap; skip what's done.
+			size_t top = (hi + 1 < end) ? hi + 1 : end;
+			for(size_t i = top; i-- > lo; ) {
+				sink(i);
+			}
+			if(lo == 0) {
+				break;
+			}
+			end = lo;
+			lo = parentIdxOf(lo);
+			hi = parentIdxOf(hi);
+		}
 	}
 
 	/**
 	 * Propagates a node **upward** to its proper place to reheapify the heap.
 	 *
 	 * @param i - the current index of the node to swim.
+	 * @return the new index of the node
 	 */
-	void swim(size_t i) {
+	size_t swim(size_t i) {
 		size_t parentIdx = parentIdxOf(i);
 
 		// While `i` is not the root and `i`'s parent has lower priority
@@ -528,6 +1549,16 @@ private:
 			i = parentIdx;
 			parentIdx = parentIdxOf(i);
 		}
+		return i;
+	}
+
+	/**
+	 * Moves node `i` up or down to its proper place, after its key changed.
+	 */
+	void reposition(size_t i) {
+		if(swim(i) == i) {
+			sink(i);
+		}
 	}
 
 	/**
@@ -537,11 +1568,8 @@ private:
 	 * @param lhs - the index of the reference node
 	 * @param rhs - the index of the node to test if `lhs` is greater than
 	 */
-	bool greaterPriority(size_t lhs, size_t rhs) {
-		bool greaterPriority = mPriorities[lhs] > mPriorities[rhs];
-		bool equalPriorityAndOlder =
-				mPriorities[lhs] == mPriorities[rhs] && mIds[lhs] < mIds[rhs];
-		return greaterPriority || equalPriorityAndOlder;
+	bool greaterPriority(size_t lhs, size_t rhs) const {
+		return mKeys.higher(lhs, rhs);
 	}
 
 	/**
@@ -549,27 +1577,35 @@ private:
 	 */
 	size_t parentIdxOf(size_t i) const {
 		// Remember, size_t is unsigned
-		return (i > 0) ? (i - 1) / 2 : i;
+		return (i > 0) ? (i - 1) / Arity : i;
 	}
 
 	/**
-	 * Returns the index of the left child of the node at `i` or `i` if
-	 * node `i` has no children.
-	 */
-	size_t leftIdxOf(size_t i) const {
-		size_t idx = 2*i+1;
-		return (idx < mSize) ? idx : i;
-	}
-
-	/*
-	 * Returns the index of the right child of the node at `i` or `i` if
-	 * node `i` has no children.
+	 * Returns the index of the first child of the node at `i`.
+	 *
+	 * The node's children are the `Arity` consecutive nodes starting here.
+	 * The result is `>= getSize()` if the node has no children.
 	 */
-	size_t rightIdxOf(size_t i) const {
-		size_t idx = 2*i+2;
-		return (idx < mSize) ? idx : i;
+	size_t firstChildIdxOf(size_t i) const {
+		return Arity*i+1;
 	}
 };
 
+#if __cplusplus >= 201703L
+/**
+ * A `PriorityQueue` that takes its memory from a `std::pmr::memory_resource`,
+ * such as a `std::pmr::monotonic_buffer_resource` arena for the queues of a
+ * single request, or a pool of huge pages.
+ *
+ *     std::pmr::monotonic_buffer_resource arena;
+ *     PmrPriorityQueue<Job> jobs(&arena);
+ */
+template<class T, class Priority=int,
+		 class Compare=std::greater<Priority>,
+		 class KeyLayout=TriadLayout, size_t Arity=2,
+		 class GrowthPolicy=LinearGrowth>
+using PmrPriorityQueue = PriorityQueue<T, Priority, Compare, KeyLayout, Arity,
+		GrowthPolicy, std::pmr::polymorphic_allocator<T> >;
+#endif
 
 #endif /* PRIORITYQUEUE_H_ */
@@ -0,0 +1,265 @@
+/*
+ * RadixHeap.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef RADIXHEAP_H_
+#define RADIXHEAP_H_
+
+#include <stdexcept>
+using std::out_of_range;
+#include <utility>
+using std::move;
+using std::forward;
+#include <vector>
+using std::vector;
+#include <deque>
+using std::deque;
+#include <cstdint>
+#include <type_traits>
+
+#include "BucketQueue.hpp"
+
+/**
+ * A lowest-first priority queue for monotone unsigned integer keys, such
+ * as the distances popped by Dijkstra's algorithm or the times in an event
+ * simulation.
+ *
+ * Monotone means no key may be smaller than the last key taken out, by
+ * `pop()` or looked at with `top()`. In exchange, there's no heap to sift:
+ * items sit in one bucket per bit of the key, by the highest bit in which
+ * they differ from that last key. `insert()` is constant time. When the
+ * items with the last key run out, the lowest non-empty bucket (found with
+ * a bitmap) is emptied into lower ones. An item can only move down each
+ * bucket once, so `pop()` is `~log C` amortized, where `C` is the spread of
+ * the keys, and usually far less.
+ *
+ * Ties leave first-in, first-out, like the default `PriorityQueue`. It has
+ * the same insert/top/pop interface.
+ */
+template<class T, class Priority=uint32_t>
+class RadixHeap {
+	static_assert(std::is_integral<Priority>::value
+			&& std::is_unsigned<Priority>::value && sizeof(Priority) <= 8,
+			"RadixHeap needs an unsigned integral priority of at most 64 bits.");
+public:
+
+	//--------------------------------------------------------------------------
+	// INSTANTIATION / COPY SEMANTICS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Constructs an empty RadixHeap.
+	 *
+	 * Everything is kept in standard containers, so the compiler-generated
+	 * copy and move operations do the right thing.
+	 */
+	RadixHeap() : mNonEmpty(0), mLast(0), mSize(0) {}
+
+	//--------------------------------------------------------------------------
+	// PUBLIC METHODS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Inserts `item` of type `T` with priority `score`.
+	 *
+	 * @param item - the item to insert (copied)
+	 * @param score - the priority of this item
+	 * @throws out_of_range if `score` is below the last key taken out
+	 */
+	void insert(const T& item, const Priority& score) {
+		emplace(score, item);
+	}
+
+	/**
+	 * Inserts `item` of type `T` with priority `score`, moving from `item`.
+	 *
+	 * @param item - the item to insert (moved)
+	 * @param score - the priority of this item
+	 * @throws out_of_range if `score` is below the last key taken out
+	 */
+	void insert(T&& item, const Priority& score) {
+		emplace(score, move(item));
+	}
+
+	/**
+	 * Constructs an item of type `T` in place from `args` and inserts it
+	 * with priority `score`.
+	 *
+	 * This is a constant time operation.
+	 *
+	 * @param score - the priority of the new item
+	 * @param args - arguments forwarded to the constructor of `T`
+	 * @throws out_of_range if `score` is below the last key taken out
+	 */
+	template<class... Args>
+	void emplace(const Priority& score, Args&&... args) {
+		if(score < mLast) {
+			throw out_of_range("RadixHeap keys must not go below the last key.");
+		}
+
+		if(score == mLast) {
+			mLowestItems.emplace_back(forward<Args>(args)...);
+		} else {
+			size_t b = bucketOf(score);
+			mBuckets[b].emplace_back(score, forward<Args>(args)...);
+			mNonEmpty |= uint64_t(1) << b;
+		}
+		mSize++;
+	}
+
+	/**
+	 * Returns a constant reference to the element with the lowest key.
+	 * Ties go to the earliest insertion.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	const T& top() const {
+		findLowest();
+		return mLowestItems.front();
+	}
+
+	/**
+	 * Returns the lowest key.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	Priority getTopPriority() const {
+		findLowest();
+		return mLast;
+	}
+
+	/**
+	 * Removes (and destroys) the element with the lowest key.
+	 */
+	void pop() {
+		if(!empty()) {
+			findLowest();
+			mLowestItems.pop_front();
+			mSize--;
+		}
+	}
+
+	/**
+	 * Removes the element with the lowest key and returns it.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	T pop_value() {
+		findLowest();
+		T item(move(mLowestItems.front()));
+		pop();
+		return item;
+	}
+
+	/**
+	 * Returns true if container is empty.
+	 */
+	bool empty() const {
+		return (getSize() == 0);
+	}
+
+	/**
+	 * Removes all items from the container, and lets keys start over at 0.
+	 */
+	void clear() {
+		mLowestItems.clear();
+		for(size_t b = 0; b < NUM_BUCKETS; b++) {
+			mBuckets[b].clear();
+		}
+		mNonEmpty = 0;
+		mLast = 0;
+		mSize = 0;
+	}
+
+	/**
+	 * Returns the number of elements in the container.
+	 */
+	const size_t getSize() const {
+		return mSize;
+	}
+
+private:
+	/**
+	 * An item waiting in a bucket, with its key.
+	 */
+	struct Node {
+		template<class... Args>
+		Node(const Priority& key, Args&&... args)
+			: mKey(key),
+			  mItem(forward<Args>(args)...)
+		{}
+
+		Priority mKey;
+		T mItem;
+	};
+
+	// A bucket per bit of the key
+	static const size_t NUM_BUCKETS = 8 * sizeof(Priority);
+
+	// Finding the lowest key rearranges the buckets, but not the contents
+	// of the heap, so `top()` can do it too.
+
+	// The items whose key is `mLast`, in insertion order
+	mutable deque<T> mLowestItems;
+	// Bucket `b` holds the keys whose highest bit differing from `mLast` is
+	// bit `b`
+	mutable vector<Node> mBuckets[NUM_BUCKETS];
+	mutable uint64_t mNonEmpty; // bit `b` is set if bucket `b` isn't empty
+	mutable Priority mLast; // the last key taken out
+	size_t mSize;
+
+	//--------------------------------------------------------------------------
+	// PRIVATE METHODS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Returns the bucket for `key`, which must be greater than `mLast`.
+	 */
+	size_t bucketOf(Priority key) const {
+		return highestBit(static_cast<uint64_t>(key ^ mLast));
+	}
+
+	/**
+	 * Makes sure the items with the lowest key are in `mLowestItems`.
+	 *
+	 * If they've all been popped, the lowest key is in the lowest non-empty
+	 * bucket. It becomes `mLast`, and the rest of that bucket is spread over
+	 * the lower buckets.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	void findLowest() const {
+		if(!mLowestItems.empty()) {
+			return;
+		}
+
+		size_t b = lowestBit(mNonEmpty);
+		vector<Node>& bucket = mBuckets[b];
+
+		Priority lowest = bucket[0].mKey;
+		for(size_t i = 1; i < bucket.size(); i++) {
+			if(bucket[i].mKey < lowest) {
+				lowest = bucket[i].mKey;
+			}
+		}
+		mLast = lowest;
+
+		// Every key here now differs from `mLast` in a lower bit.
+		// Moving them in order keeps equal keys first-in, first-out.
+		for(size_t i = 0; i < bucket.size(); i++) {
+			if(bucket[i].mKey == mLast) {
+				mLowestItems.push_back(move(bucket[i].mItem));
+			} else {
+				size_t lower = bucketOf(bucket[i].mKey);
+				mBuckets[lower].push_back(move(bucket[i]));
+				mNonEmpty |= uint64_t(1) << lower;
+			}
+		}
+		bucket.clear();
+		mNonEmpty &= ~(uint64_t(1) << b);
+	}
+};
+
+#endif /* RADIXHEAP_H_ */
@@ -0,0 +1,229 @@
+/*
+ * SiblingSelect.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef SIBLINGSELECT_H_
+#define SIBLINGSELECT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#if defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+#include "HeapKeys.hpp"
+
+/**
+ * Returns the index of the best of the `count` keys starting at `first`,
+ * comparing them one by one.
+ */
+template<class Keys>
+size_t scanSiblings(const Keys& keys, size_t first, size_t count) {
+	size_t best = first;
+	for(size_t c = first + 1; c < first + count; c++) {
+		if(keys.higher(c, best)) {
+			best = c;
+		}
+	}
+	return best;
+}
+
+/**
+ * Picks the best of a group of siblings for `PriorityQueue::sink()`.
+ *
+ * `best(keys, first, count)` returns the index of the best of the `count`
+ * keys starting at `first`; `count` is `Arity` except for the last group.
+ *
+ * This version compares them one by one. When the compiler targets SSE4.1
+ * or AVX2 (e.g. `-msse4.1`, `-mavx2` or `-march=native`), full groups of
+ * 4 or 8 siblings are compared at once instead, for triad layouts and
+ * `UnstableLayout` with 32-bit integral priorities and `std::greater` or
+ * `std::less`, and for `AddressableLayout` wrapping either.
+ *
+ * `FusedKeyLayout` stays scalar: there's no unsigned 64-bit vector compare
+ * before AVX-512, and working around that took longer than the scalar
+ * compares it replaced.
+ */
+template<size_t Arity, class Keys, class Enable=void>
+struct SiblingSelect {
+	static size_t best(const Keys& keys, size_t first, size_t count) {
+		return scanSiblings(keys, first, count);
+	}
+};
+
+/**
+ * Addressable keys select like the keys they wrap.
+ */
+template<size_t Arity, class Layout, class Priority, class Compare>
+struct SiblingSelect<Arity,
+		HeapKeys<AddressableLayout<Layout>, Priority, Compare> > {
+	typedef HeapKeys<AddressableLayout<Layout>, Priority, Compare> Keys;
+	typedef HeapKeys<Layout, Priority, Compare> Inner;
+
+	static size_t best(const Keys& keys, size_t first, size_t count) {
+		return SiblingSelect<Arity, Inner>::best(keys.inner(), first, count);
+	}
+};
+
+#if defined(__SSE4_1__)
+
+/**
+ * Vector kernels. Each returns a bitmask of the lanes holding the best
+ * value, in lane order.
+ */
+namespace simd {
+
+/**
+ * Lane-wise best of 32-bit integers, by signedness and direction.
+ */
+template<bool Signed, bool HighestFirst>
+struct Int32Lanes;
+
+template<>
+struct Int32Lanes<true, true> {
+	static __m128i best(__m128i a, __m128i b) { return _mm_max_epi32(a, b); }
+#if defined(__AVX2__)
+	static __m256i best(__m256i a, __m256i b) { return _mm256_max_epi32(a, b); }
+#endif
+};
+
+template<>
+struct Int32Lanes<true, false> {
+	static __m128i best(__m128i a, __m128i b) { return _mm_min_epi32(a, b); }
+#if defined(__AVX2__)
+	static __m256i best(__m256i a, __m256i b) { return _mm256_min_epi32(a, b); }
+#endif
+};
+
+template<>
+struct Int32Lanes<false, true> {
+	static __m128i best(__m128i a, __m128i b) { return _mm_max_epu32(a, b); }
+#if defined(__AVX2__)
+	static __m256i best(__m256i a, __m256i b) { return _mm256_max_epu32(a, b); }
+#endif
+};
+
+template<>
+struct Int32Lanes<false, false> {
+	static __m128i best(__m128i a, __m128i b) { return _mm_min_epu32(a, b); }
+#if defined(__AVX2__)
+	static __m256i best(__m256i a, __m256i b) { return _mm256_min_epu32(a, b); }
+#endif
+};
+
+/**
+ * Returns `v` with the best of its 4 lanes in every lane.
+ */
+template<class Lanes>
+__m128i spreadBest(__m128i v) {
+	v = Lanes::best(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return Lanes::best(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+/**
+ * Returns the lanes of `v` that equal `best`.
+ */
+inline unsigned lanesEqual(__m128i v, __m128i best) {
+	return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, best)));
+}
+
+/**
+ * The best lanes of `Width` 32-bit integers.
+ */
+template<size_t Width, bool Signed, bool HighestFirst>
+struct Int32Kernel;
+
+template<bool Signed, bool HighestFirst>
+struct Int32Kernel<4, Signed, HighestFirst> {
+	static unsigned bestLanes(const void* p) {
+		typedef Int32Lanes<Signed, HighestFirst> Lanes;
+		__m128i v = _mm_loadu_si128(static_cast<const __m128i*>(p));
+		return lanesEqual(v, spreadBest<Lanes>(v));
+	}
+};
+
+template<bool Signed, bool HighestFirst>
+struct Int32Kernel<8, Signed, HighestFirst> {
+	static unsigned bestLanes(const void* p) {
+		typedef Int32Lanes<Signed, HighestFirst> Lanes;
+#if defined(__AVX2__)
+		__m256i v = _mm256_loadu_si256(static_cast<const __m256i*>(p));
+		__m256i m = Lanes::best(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+		m = Lanes::best(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+		m = Lanes::best(m, _mm256_permute2x128_si256(m, m, 1));
+		return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, m)));
+#else
+		const __m128i* q = static_cast<const __m128i*>(p);
+		__m128i lo = _mm_loadu_si128(q);
+		__m128i hi = _mm_loadu_si128(q + 1);
+		__m128i m = spreadBest<Lanes>(Lanes::best(lo, hi));
+		return lanesEqual(lo, m) | (lanesEqual(hi, m) << 4);
+#endif
+	}
+};
+
+} /* End namespace simd */
+
+/**
+ * Whether groups of `Arity` `Priority`s ordered by `Compare` have a kernel.
+ */
+template<size_t Arity, class Priority, class Compare>
+struct HasInt32Kernel : std::integral_constant<bool,
+		(Arity == 4 || Arity == 8)
+		&& std::is_integral<Priority>::value && sizeof(Priority) == 4
+		&& KeyDirection<Compare>::KNOWN> {};
+
+/**
+ * Triad keys: the best priorities are found at once, and ties (rare) are
+ * broken by id.
+ */
+template<size_t Arity, class Id, class Priority, class Compare>
+struct SiblingSelect<Arity, HeapKeys<BasicTriadLayout<Id>, Priority, Compare>,
+		typename std::enable_if<
+			HasInt32Kernel<Arity, Priority, Compare>::value>::type> {
+	typedef HeapKeys<BasicTriadLayout<Id>, Priority, Compare> Keys;
+	typedef simd::Int32Kernel<Arity, std::is_signed<Priority>::value,
+			KeyDirection<Compare>::HIGHEST_FIRST> Kernel;
+
+	static size_t best(const Keys& keys, size_t first, size_t count) {
+		if(count != Arity) {
+			return scanSiblings(keys, first, count);
+		}
+
+		unsigned lanes = Kernel::bestLanes(keys.priorities() + first);
+		size_t best = first + lowestBit(lanes);
+		for(lanes &= lanes - 1; lanes != 0; lanes &= lanes - 1) {
+			size_t c = first + lowestBit(lanes);
+			if(keys.id(c) < keys.id(best)) {
+				best = c;
+			}
+		}
+		return best;
+	}
+};
+
+/**
+ * Unstable keys: any of the best priorities will do.
+ */
+template<size_t Arity, class Priority, class Compare>
+struct SiblingSelect<Arity, HeapKeys<UnstableLayout, Priority, Compare>,
+		typename std::enable_if<
+			HasInt32Kernel<Arity, Priority, Compare>::value>::type> {
+	typedef HeapKeys<UnstableLayout, Priority, Compare> Keys;
+	typedef simd::Int32Kernel<Arity, std::is_signed<Priority>::value,
+			KeyDirection<Compare>::HIGHEST_FIRST> Kernel;
+
+	static size_t best(const Keys& keys, size_t first, size_t count) {
+		if(count != Arity) {
+			return scanSiblings(keys, first, count);
+		}
+		return first + lowestBit(Kernel::bestLanes(keys.priorities() + first));
+	}
+};
+
+#endif /* __SSE4_1__ */
+
+#endif /* SIBLINGSELECT_H_ */
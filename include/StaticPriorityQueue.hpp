@@ -0,0 +1,368 @@
+/*
+ * StaticPriorityQueue.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef STATICPRIORITYQUEUE_H_
+#define STATICPRIORITYQUEUE_H_
+
+#include <stdexcept>
+using std::length_error;
+#include <new>
+#include <utility>
+using std::move;
+using std::forward;
+#include <functional>
+#include <type_traits>
+
+#include "HeapKeys.hpp"
+#include "SiblingSelect.hpp"
+
+/**
+ * A priority queue of at most `N` items, stored inline.
+ *
+ * Nothing is ever allocated: the items and the key arrays live inside the
+ * object, so a StaticPriorityQueue on the stack makes no allocator calls at
+ * all. That suits the many queues that only ever hold a few dozen items,
+ * which `PriorityQueue` would give a heap block of `DEFAULT_INITIAL_CAPACITY`
+ * nodes each. Inserting into a full queue throws `length_error`; check
+ * `full()` first if that can happen, or use a `PriorityQueue`.
+ *
+ * Priorities, comparators, key layouts and arity work as in `PriorityQueue`,
+ * and it has the same insert/top/pop interface. Handles aren't supported.
+ */
+template<class T, size_t N, class Priority=int,
+		 class Compare=std::greater<Priority>,
+		 class KeyLayout=TriadLayout, size_t Arity=2>
+class StaticPriorityQueue {
+	static_assert(N > 0, "A StaticPriorityQueue needs room for an item.");
+	static_assert(Arity >= 2, "A heap needs at least two children per node.");
+	typedef HeapKeys<KeyLayout, Priority, Compare> Keys;
+	static_assert(std::is_same<typename Keys::Handle, NoHandle>::value,
+			"StaticPriorityQueue doesn't support handles.");
+public:
+
+	//--------------------------------------------------------------------------
+	// INSTANTIATION / COPY SEMANTICS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Constructs an empty StaticPriorityQueue.
+	 */
+	StaticPriorityQueue() : mSize(0), mNextId(0) {
+		placeKeys();
+	}
+
+	/**
+	 * Copy Constructor
+	 */
+	StaticPriorityQueue(const StaticPriorityQueue& src)
+		: mSize(0),
+		  mNextId(0)
+	{
+		placeKeys();
+		copyFrom(src);
+	}
+
+	/**
+	 * Move Constructor.
+	 *
+	 * The items live inline, so they're moved one by one, leaving `src`
+	 * empty.
+	 */
+	StaticPriorityQueue(StaticPriorityQueue&& src)
+		: mSize(0),
+		  mNextId(0)
+	{
+		placeKeys();
+		moveFrom(src);
+	}
+
+	/**
+	 * Copy assignment operator.
+	 */
+	StaticPriorityQueue& operator=(const StaticPriorityQueue& rhs) {
+		if(this != &rhs) {
+			clear();
+			copyFrom(rhs);
+		}
+		return *this;
+	}
+
+	/**
+	 * Move assignment operator. Leaves `rhs` empty.
+	 */
+	StaticPriorityQueue& operator=(StaticPriorityQueue&& rhs) {
+		if(this != &rhs) {
+			clear();
+			moveFrom(rhs);
+		}
+		return *this;
+	}
+
+	/// Destructor. Not virtual, so the queue carries no vtable pointer.
+	~StaticPriorityQueue() {
+		clear();
+	}
+
+	//--------------------------------------------------------------------------
+	// PUBLIC METHODS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Inserts `item` of type `T` with priority `score`.
+	 *
+	 * This is a `~log n` operation.
+	 *
+	 * @param item - the item to insert (copied)
+	 * @param score - the priority of this item
+	 * @throws length_error if the queue is full
+	 */
+	void insert(const T& item, const Priority& score) {
+		emplace(score, item);
+	}
+
+	/**
+	 * Inserts `item` of type `T` with priority `score`, moving from `item`.
+	 *
+	 * @param item - the item to insert (moved)
+	 * @param score - the priority of this item
+	 * @throws length_error if the queue is full
+	 */
+	void insert(T&& item, const Priority& score) {
+		emplace(score, move(item));
+	}
+
+	/**
+	 * Constructs an item of type `T` in place from `args` and inserts it
+	 * with priority `score`.
+	 *
+	 * @param score - the priority of the new item
+	 * @param args - arguments forwarded to the constructor of `T`
+	 * @throws length_error if the queue is full
+	 */
+	template<class... Args>
+	void emplace(const Priority& score, Args&&... args) {
+		if(full()) {
+			throw length_error("StaticPriorityQueue is full.");
+		}
+		checkIdOverflow();
+
+		size_t i = mSize;
+		new(items() + i) T(forward<Args>(args)...);
+		mKeys.construct(i, score, mNextId);
+		mNextId++;
+		mSize++;
+		swim(i);
+	}
+
+	/**
+	 * Returns a constant reference to the element with the highest priority.
+	 * Ties go to the earliest insertion, unless the key layout is
+	 * `UnstableLayout`.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	const T& top() const {
+		return items()[0];
+	}
+
+	/**
+	 * Returns the priority of the element with the highest priority.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	Priority getTopPriority() const {
+		return mKeys.priority(0);
+	}
+
+	/**
+	 * Removes (and destroys) the element with the highest priority.
+	 *
+	 * This is a `~2log n` operation.
+	 */
+	void pop() {
+		if(empty()) {
+			return;
+		}
+
+		// Replace the root with the last node and sink it
+		T* nodes = items();
+		size_t last = mSize - 1;
+		mKeys.destroy(0);
+		if(last > 0) {
+			nodes[0] = move(nodes[last]);
+			mKeys.move(last, 0);
+		}
+		nodes[last].~T();
+		mSize--;
+		sink(0);
+	}
+
+	/**
+	 * Removes the element with the highest priority and returns it.
+	 *
+	 * Calling this function on an empty container causes undefined behavior.
+	 */
+	T pop_value() {
+		T item(move(items()[0]));
+		pop();
+		return item;
+	}
+
+	/**
+	 * Returns true if container is empty.
+	 */
+	bool empty() const {
+		return (getSize() == 0);
+	}
+
+	/**
+	 * Returns true if no more items fit.
+	 */
+	bool full() const {
+		return (getSize() == N);
+	}
+
+	/**
+	 * Removes all items from the container.
+	 */
+	void clear() {
+		T* nodes = items();
+		for(size_t i = 0; i < mSize; i++) {
+			nodes[i].~T();
+			mKeys.destroy(i);
+		}
+		mSize = 0;
+	}
+
+	/**
+	 * Returns the number of elements in the container.
+	 */
+	const size_t getSize() const {
+		return mSize;
+	}
+
+	/**
+	 * Returns the fixed capacity, `N`.
+	 */
+	static constexpr size_t getCapacity() {
+		return N;
+	}
+
+private:
+	// The key arrays are carved out of `mKeyStorage`, like a
+	// `PriorityQueue` carves them out of its block.
+	alignas(T) unsigned char mItemStorage[N * sizeof(T)];
+	unsigned char mKeyStorage[Keys::storageSize(N)];
+	Keys mKeys;
+	size_t mSize;
+	size_t mNextId; // the id of the next inserted item
+
+	//--------------------------------------------------------------------------
+	// PRIVATE METHODS
+	//--------------------------------------------------------------------------
+
+	T* items() {
+		return reinterpret_cast<T*>(mItemStorage);
+	}
+
+	const T* items() const {
+		return reinterpret_cast<const T*>(mItemStorage);
+	}
+
+	/**
+	 * Points the keys at their arrays in `mKeyStorage`.
+	 */
+	void placeKeys() {
+		unsigned char* cursor = mKeyStorage;
+		mKeys.place(cursor, N);
+	}
+
+	/**
+	 * Copies the nodes of `src` into this empty queue.
+	 */
+	void copyFrom(const StaticPriorityQueue& src) {
+		const T* srcItems = src.items();
+		for(; mSize < src.mSize; mSize++) {
+			new(items() + mSize) T(srcItems[mSize]);
+		}
+		mKeys.copy(src.mKeys, mSize);
+		mNextId = src.mNextId;
+	}
+
+	/**
+	 * Moves the nodes of `src` into this empty queue, leaving `src` empty.
+	 */
+	void moveFrom(StaticPriorityQueue& src) {
+		T* srcItems = src.items();
+		for(; mSize < src.mSize; mSize++) {
+			new(items() + mSize) T(move(srcItems[mSize]));
+		}
+		mKeys.copy(src.mKeys, mSize);
+		mNextId = src.mNextId;
+		src.clear();
+	}
+
+	/**
+	 * Swaps node `a` with node `b` across all arrays.
+	 */
+	void swapNodes(size_t a, size_t b) {
+		using std::swap;
+		swap(items()[a], items()[b]);
+		mKeys.swap(a, b);
+	}
+
+	/**
+	 * Frees up ids before they overflow what the key layout can store, the
+	 * same way `PriorityQueue` does. See `consolidateNodeIds()`.
+	 *
+	 * @throws length_error only if the queue already holds `MAX_ID` items
+	 */
+	void checkIdOverflow() {
+		if(mNextId != Keys::MAX_ID) {
+			return;
+		}
+		if(mSize >= Keys::MAX_ID) {
+			throw length_error(
+					"StaticPriorityQueue has run out of insertion ids.");
+		}
+		auto swapper = [this](size_t a, size_t b) { swapNodes(a, b); };
+		if(consolidateNodeIds(mKeys, mSize, mNextId, swapper)) {
+			// Floyd's heap construction, from the last parent up
+			for(size_t i = (mSize + Arity - 2) / Arity; i-- > 0; ) {
+				sink(i);
+			}
+		}
+	}
+
+	/**
+	 * Propagates a node **downward** to its proper place to reheapify the heap.
+	 */
+	void sink(size_t i) {
+		while(Arity*i + 1 < mSize) {
+			size_t firstIdx = Arity*i + 1;
+			size_t count = (mSize - firstIdx > Arity) ? Arity : mSize - firstIdx;
+			size_t childIdx =
+					SiblingSelect<Arity, Keys>::best(mKeys, firstIdx, count);
+			if(!mKeys.higher(childIdx, i)) {
+				return;
+			}
+			swapNodes(childIdx, i);
+			i = childIdx;
+		}
+	}
+
+	/**
+	 * Propagates a node **upward** to its proper place to reheapify the heap.
+	 */
+	void swim(size_t i) {
+		while(i > 0 && mKeys.higher(i, (i - 1) / Arity)) {
+			swapNodes(i, (i - 1) / Arity);
+			i = (i - 1) / Arity;
+		}
+	}
+};
+
+#endif /* STATICPRIORITYQUEUE_H_ */
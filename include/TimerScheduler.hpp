@@ -0,0 +1,597 @@
+/*
+ * TimerScheduler.hpp
+ *
+ *  Created on: Oct 15, 2026
+ */
+
+#ifndef TIMERSCHEDULER_H_
+#define TIMERSCHEDULER_H_
+
+#include <chrono>
+#include <functional>
+#include <limits>
+using std::numeric_limits;
+#include <stdexcept>
+using std::out_of_range;
+#include <utility>
+using std::move;
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+#include "PriorityQueue.hpp"
+
+/**
+ * Schedules items (by default, callbacks) to run at deadlines on `Clock`.
+ *
+ * Near deadlines go in a hierarchical timer wheel (Varghese & Lauck,
+ * "Hashed and Hierarchical Timing Wheels", 1987): `LEVELS` wheels of
+ * `SLOTS` slots each, where a slot of level `k` spans `SLOTS^k` ticks of
+ * `resolution`. A timer goes in the lowest level whose slot is still ahead
+ * of the current tick; as time reaches a slot, its timers drop down a level
+ * until they reach level 0 and are due. Scheduling and cancelling are
+ * constant time, and each timer moves down at most `LEVELS` times, so
+ * `run_due()` is constant time per timer, amortized. Empty slots are
+ * skipped with a bitmap per level, so a long gap between calls costs
+ * nothing. Deadlines beyond the wheels (`SLOTS^LEVELS` ticks, about 4.7
+ * hours at the default 1 ms) overflow into a `PriorityQueue` and move into
+ * the wheels when they come within range.
+ *
+ * Deadlines are rounded up to a whole tick, so an item never runs before
+ * its deadline, and runs at most a tick late if `run_due()` is called on
+ * time. `next_wakeup()` says how long a caller can sleep instead of
+ * polling. A deadline of `TimePoint::max()` never comes: such a timer
+ * waits until it's cancelled.
+ *
+ * Timers run in order of their deadline tick. Timers scheduled in the past
+ * run first, and the order of timers due in the same tick isn't specified.
+ *
+ * `T` must be default constructible and move assignable: timers are kept
+ * in a pool, and items are moved in and out.
+ */
+template<class T=std::function<void()>, class Clock=std::chrono::steady_clock>
+class TimerScheduler {
+public:
+	typedef typename Clock::time_point TimePoint;
+	typedef typename Clock::duration Duration;
+
+	// Levels of wheels, and slots per wheel (one bit each in a bitmap)
+	static const size_t LEVELS = 4;
+	static const size_t SLOTS = 64;
+
+	/**
+	 * Identifies a scheduled timer until it runs or is cancelled.
+	 *
+	 * A default-constructed handle identifies no timer.
+	 */
+	struct Handle {
+		size_t mIndex;
+		size_t mGeneration;
+
+		Handle() : mIndex(NIL), mGeneration(0) {}
+		Handle(size_t index, size_t generation)
+			: mIndex(index),
+			  mGeneration(generation)
+		{}
+	};
+
+	//--------------------------------------------------------------------------
+	// INSTANTIATION / COPY SEMANTICS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Constructs an empty TimerScheduler.
+	 *
+	 * The compiler-generated copy and move operations do the right thing;
+	 * handles stay valid in the copy.
+	 *
+	 * @param resolution - the length of a tick. Deadlines are rounded up to
+	 *                     a whole tick.
+	 * @param origin - the time of tick 0. Deadlines before it are due.
+	 * @throws out_of_range if `resolution` isn't positive
+	 */
+	explicit TimerScheduler(
+			Duration resolution=std::chrono::milliseconds(1),
+			TimePoint origin=Clock::now())
+		: mResolution(resolution),
+		  mOrigin(origin),
+		  mNow(0),
+		  mSize(0),
+		  mFree(NIL)
+	{
+		if(resolution <= Duration::zero()) {
+			throw out_of_range("A TimerScheduler needs a positive resolution.");
+		}
+		for(size_t level = 0; level < LEVELS; level++) {
+			mOccupied[level] = 0;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// PUBLIC METHODS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Schedules `item` to run at `deadline`.
+	 *
+	 * This is a constant time operation, or `~log n` if `deadline` is
+	 * beyond the wheels.
+	 *
+	 * @param deadline - when to run the item; it's due from then on
+	 * @param item - the item to schedule (copied)
+	 * @return a handle to cancel the timer with
+	 */
+	Handle schedule_at(TimePoint deadline, const T& item) {
+		return schedule_at(deadline, T(item));
+	}
+
+	/**
+	 * Schedules `item` to run at `deadline`, moving from `item`.
+	 *
+	 * @param deadline - when to run the item; it's due from then on
+	 * @param item - the item to schedule (moved)
+	 * @return a handle to cancel the timer with
+	 */
+	Handle schedule_at(TimePoint deadline, T&& item) {
+		size_t i = allocateNode();
+		Node& node = mNodes[i];
+		node.mItem = move(item);
+		node.mTick = tickAtOrAfter(deadline);
+		place(i);
+		mSize++;
+		return Handle(i, node.mGeneration);
+	}
+
+	/**
+	 * Schedules `item` to run `delay` from now, by `Clock`.
+	 *
+	 * @param delay - how long from now to run the item
+	 * @param item - the item to schedule (copied)
+	 * @return a handle to cancel the timer with
+	 */
+	Handle schedule_after(Duration delay, const T& item) {
+		return schedule_at(Clock::now() + delay, item);
+	}
+
+	/**
+	 * Schedules `item` to run `delay` from now, by `Clock`, moving from
+	 * `item`.
+	 *
+	 * @param delay - how long from now to run the item
+	 * @param item - the item to schedule (moved)
+	 * @return a handle to cancel the timer with
+	 */
+	Handle schedule_after(Duration delay, T&& item) {
+		return schedule_at(Clock::now() + delay, move(item));
+	}
+
+	/**
+	 * Cancels the timer with `handle`, destroying its item.
+	 *
+	 * This is a constant time operation.
+	 *
+	 * @return false if the timer already ran or was cancelled
+	 */
+	bool cancel(Handle handle) {
+		if(!pending(handle)) {
+			return false;
+		}
+		size_t i = handle.mIndex;
+		if(mNodes[i].mList == IN_OVERFLOW) {
+			mOverflow.cancel(mNodes[i].mOverflowHandle);
+		} else {
+			unlink(i);
+		}
+		releaseNode(i);
+		mSize--;
+		return true;
+	}
+
+	/**
+	 * Returns true if the timer with `handle` has neither run nor been
+	 * cancelled.
+	 */
+	bool pending(Handle handle) const {
+		return handle.mIndex < mNodes.size()
+				&& mNodes[handle.mIndex].mGeneration == handle.mGeneration
+				&& mNodes[handle.mIndex].mList != FREE;
+	}
+
+	/**
+	 * Runs every item due by `now`, by calling it.
+	 *
+	 * @param now - the current time
+	 * @return the number of items run
+	 */
+	size_t run_due(TimePoint now) {
+		return run_due(now, [](T& item) { item(); });
+	}
+
+	/**
+	 * Passes every item due by `now` to `callback`, as a `T&`, then
+	 * destroys it.
+	 *
+	 * The callback may schedule and cancel timers. Timers it schedules are
+	 * left for the next call, even if they're already due. If it throws, the
+	 * items not yet passed stay due.
+	 *
+	 * @param now - the current time
+	 * @param callback - called with each due item
+	 * @return the number of items passed to `callback`
+	 */
+	template<class Callback>
+	size_t run_due(TimePoint now, Callback callback) {
+		advanceTo(tickAtOrBefore(now));
+
+		// Run from a list of their own, so that timers scheduled or made
+		// due by the callbacks wait for the next call
+		splice(DUE_LIST, RUNNING_LIST);
+		size_t count = 0;
+		try {
+			while(mLists[RUNNING_LIST].mHead != NIL) {
+				size_t i = mLists[RUNNING_LIST].mHead;
+				unlink(i);
+				mSize--;
+				// Keep the item alive in case the callback cancels itself
+				T item(move(mNodes[i].mItem));
+				releaseNode(i);
+				callback(item);
+				count++;
+			}
+		} catch(...) {
+			// Put the rest back at the front of the due list
+			splice(DUE_LIST, RUNNING_LIST);
+			splice(RUNNING_LIST, DUE_LIST);
+			throw;
+		}
+		return count;
+	}
+
+	/**
+	 * Returns a time at or before the earliest pending deadline, so a
+	 * caller can sleep until then instead of polling. It's the current tick
+	 * if timers are due, and `TimePoint::max()` if there are no timers.
+	 *
+	 * The earliest deadline is only known to within the slot it's in, so
+	 * after waking up and calling `run_due()` there may be nothing to run
+	 * yet; the next wakeup is then closer.
+	 */
+	TimePoint next_wakeup() const {
+		if(mLists[DUE_LIST].mHead != NIL) {
+			return timeOf(mNow);
+		}
+		uint64_t tick;
+		if(!nextEvent(tick)) {
+			return TimePoint::max();
+		}
+		return timeOf(tick);
+	}
+
+	/**
+	 * Returns true if no timers are pending.
+	 */
+	bool empty() const {
+		return (getSize() == 0);
+	}
+
+	/**
+	 * Returns the number of pending timers.
+	 */
+	const size_t getSize() const {
+		return mSize;
+	}
+
+	/**
+	 * Returns the length of a tick.
+	 */
+	Duration getResolution() const {
+		return mResolution;
+	}
+
+private:
+	static const size_t NIL = numeric_limits<size_t>::max();
+	static const unsigned SLOT_BITS = 6; // log2(SLOTS)
+	static_assert(SLOTS == size_t(1) << SLOT_BITS, "Wheels use 64-bit bitmaps.");
+
+	// Lists of timers: one per wheel slot, then these
+	static const size_t DUE_LIST = LEVELS * SLOTS;
+	static const size_t RUNNING_LIST = DUE_LIST + 1;
+	static const size_t NUM_LISTS = RUNNING_LIST + 1;
+	// Where timers not in a list are
+	static const size_t IN_OVERFLOW = NUM_LISTS;
+	static const size_t FREE = NUM_LISTS + 1;
+
+	typedef PriorityQueue<size_t, uint64_t, std::less<uint64_t>,
+			AddressableLayout<>, 2, GeometricGrowth> OverflowQueue;
+
+	/**
+	 * A timer, linked into the list it's in.
+	 */
+	struct Node {
+		T mItem;
+		uint64_t mTick; // the deadline, in ticks
+		size_t mList; // the list it's in, `IN_OVERFLOW` or `FREE`
+		size_t mPrev;
+		size_t mNext; // also links free nodes
+		size_t mGeneration; // bumped when freed, to invalidate handles
+		typename OverflowQueue::Handle mOverflowHandle;
+	};
+
+	struct List {
+		size_t mHead;
+		size_t mTail;
+
+		List() : mHead(NIL), mTail(NIL) {}
+	};
+
+	Duration mResolution;
+	TimePoint mOrigin;
+	uint64_t mNow; // every timer due by this tick is in the due list
+	size_t mSize;
+	vector<Node> mNodes;
+	size_t mFree; // the first free node
+	List mLists[NUM_LISTS];
+	uint64_t mOccupied[LEVELS]; // a bit per non-empty slot
+	OverflowQueue mOverflow; // node indexes, by tick
+
+	//--------------------------------------------------------------------------
+	// PRIVATE METHODS
+	//--------------------------------------------------------------------------
+
+	/**
+	 * Returns the time from `mOrigin` to `time`, which must be after it,
+	 * or `Duration::max()` if that's too long to represent.
+	 */
+	Duration sinceOrigin(TimePoint time) const {
+		Duration origin = mOrigin.time_since_epoch();
+		if(origin < Duration::zero()
+				&& time.time_since_epoch() > Duration::max() + origin) {
+			return Duration::max();
+		}
+		return time - mOrigin;
+	}
+
+	/**
+	 * Returns the last tick whose start `TimePoint` can represent.
+	 */
+	uint64_t lastTick() const {
+		return static_cast<uint64_t>(sinceOrigin(TimePoint::max()) / mResolution);
+	}
+
+	/**
+	 * Returns the first tick that starts at or after `time`.
+	 *
+	 * A deadline after the start of `lastTick()`, like `TimePoint::max()`,
+	 * gets the tick after it. `run_due()` never gets that far, so the timer
+	 * never runs.
+	 */
+	uint64_t tickAtOrAfter(TimePoint time) const {
+		if(time <= mOrigin) {
+			return 0;
+		}
+		// Rounding up by adding `mResolution` first could overflow
+		Duration since = sinceOrigin(time);
+		return static_cast<uint64_t>(since / mResolution)
+				+ (since % mResolution != Duration::zero());
+	}
+
+	/**
+	 * Returns the last tick that starts at or before `time`.
+	 */
+	uint64_t tickAtOrBefore(TimePoint time) const {
+		if(time <= mOrigin) {
+			return 0;
+		}
+		return static_cast<uint64_t>(sinceOrigin(time) / mResolution);
+	}
+
+	/**
+	 * Returns the start of `tick`, or `TimePoint::max()` if it's past
+	 * `lastTick()`.
+	 */
+	TimePoint timeOf(uint64_t tick) const {
+		if(tick > lastTick()) {
+			return TimePoint::max();
+		}
+		return mOrigin + mResolution * static_cast<typename Duration::rep>(tick);
+	}
+
+	/**
+	 * Returns the slot of `tick` in the wheel of `level`.
+	 */
+	static size_t slotOf(uint64_t tick, size_t level) {
+		return (tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+	}
+
+	/**
+	 * Returns `tick` with the bits below the slots of `level` cleared.
+	 */
+	static uint64_t startOfLevel(uint64_t tick, size_t level) {
+		unsigned bits = SLOT_BITS * level;
+		return (bits >= 64) ? 0 : (tick >> bits) << bits;
+	}
+
+	/**
+	 * Files timer `i` by its tick: in the due list if it's due, in the
+	 * lowest wheel where its slot is still ahead of `mNow`, or in the
+	 * overflow queue.
+	 *
+	 * A timer goes in `level` when its tick and `mNow` agree on every bit
+	 * above that level's slots. Its slot there is then ahead of `mNow`'s,
+	 * and when time reaches it, the timer moves to a lower level.
+	 */
+	void place(size_t i) {
+		uint64_t tick = mNodes[i].mTick;
+		if(tick <= mNow) {
+			append(DUE_LIST, i);
+			return;
+		}
+		for(size_t level = 0; level < LEVELS; level++) {
+			if(startOfLevel(tick, level + 1) == startOfLevel(mNow, level + 1)) {
+				size_t slot = slotOf(tick, level);
+				append(level * SLOTS + slot, i);
+				mOccupied[level] |= uint64_t(1) << slot;
+				return;
+			}
+		}
+		mNodes[i].mList = IN_OVERFLOW;
+		mNodes[i].mOverflowHandle = mOverflow.insert(i, tick);
+	}
+
+	/**
+	 * Finds the next tick after `mNow` at which something happens: the
+	 * start of the first non-empty slot ahead of `mNow` on the lowest level
+	 * that has one, or else the start of the top-level span of the
+	 * earliest overflowed timer.
+	 *
+	 * @return false if there are no timers in the wheels or overflow
+	 */
+	bool nextEvent(uint64_t& tick) const {
+		for(size_t level = 0; level < LEVELS; level++) {
+			size_t current = slotOf(mNow, level);
+			uint64_t ahead = (current + 1 < SLOTS)
+					? mOccupied[level] & (~uint64_t(0) << (current + 1)) : 0;
+			if(ahead != 0) {
+				tick = startOfLevel(mNow, level + 1)
+						| (uint64_t(lowestBit(ahead)) << (SLOT_BITS * level));
+				return true;
+			}
+		}
+		if(!mOverflow.empty()) {
+			tick = startOfLevel(mOverflow.getTopPriority(), LEVELS);
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Moves time forward to `target`, filing every timer due by then in the
+	 * due list.
+	 *
+	 * Only ticks where something happens are visited. Timers stay where
+	 * they are between those: their slots are still ahead.
+	 */
+	void advanceTo(uint64_t target) {
+		uint64_t tick;
+		while(mNow < target && nextEvent(tick) && tick <= target) {
+			mNow = tick;
+
+			// Overflowed timers that are now in range move into the wheels
+			while(!mOverflow.empty() && startOfLevel(mOverflow.getTopPriority(),
+					LEVELS) == startOfLevel(mNow, LEVELS)) {
+				size_t i = mOverflow.pop_value();
+				place(i);
+			}
+
+			// Time has reached the current slot of each level, from the top
+			// down: its timers move to lower levels, or are due
+			for(size_t level = LEVELS; level-- > 0; ) {
+				size_t slot = slotOf(mNow, level);
+				if(mOccupied[level] & (uint64_t(1) << slot)) {
+					mOccupied[level] &= ~(uint64_t(1) << slot);
+					size_t list = level * SLOTS + slot;
+					while(mLists[list].mHead != NIL) {
+						size_t i = mLists[list].mHead;
+						unlink(i);
+						place(i);
+					}
+				}
+			}
+		}
+		if(mNow < target) {
+			mNow = target;
+		}
+	}
+
+	/**
+	 * Returns a free node, growing the pool if there's none.
+	 */
+	size_t allocateNode() {
+		if(mFree == NIL) {
+			mNodes.push_back(Node());
+			Node& node = mNodes.back();
+			node.mGeneration = 0;
+			node.mList = FREE;
+			return mNodes.size() - 1;
+		}
+		size_t i = mFree;
+		mFree = mNodes[i].mNext;
+		return i;
+	}
+
+	/**
+	 * Returns node `i`, no longer in any list, to the pool.
+	 */
+	void releaseNode(size_t i) {
+		Node& node = mNodes[i];
+		node.mItem = T();
+		node.mList = FREE;
+		node.mGeneration++;
+		node.mNext = mFree;
+		mFree = i;
+	}
+
+	/**
+	 * Appends node `i` to `list`.
+	 */
+	void append(size_t list, size_t i) {
+		Node& node = mNodes[i];
+		node.mList = list;
+		node.mPrev = mLists[list].mTail;
+		node.mNext = NIL;
+		if(node.mPrev == NIL) {
+			mLists[list].mHead = i;
+		} else {
+			mNodes[node.mPrev].mNext = i;
+		}
+		mLists[list].mTail = i;
+	}
+
+	/**
+	 * Takes node `i` out of its list, clearing the slot's bit if that
+	 * empties a wheel slot.
+	 */
+	void unlink(size_t i) {
+		Node& node = mNodes[i];
+		List& list = mLists[node.mList];
+		if(node.mPrev == NIL) {
+			list.mHead = node.mNext;
+		} else {
+			mNodes[node.mPrev].mNext = node.mNext;
+		}
+		if(node.mNext == NIL) {
+			list.mTail = node.mPrev;
+		} else {
+			mNodes[node.mNext].mPrev = node.mPrev;
+		}
+		if(list.mHead == NIL && node.mList < DUE_LIST) {
+			size_t level = node.mList / SLOTS;
+			mOccupied[level] &= ~(uint64_t(1) << (node.mList % SLOTS));
+		}
+	}
+
+	/**
+	 * Moves all of list `from` to the end of list `to`.
+	 */
+	void splice(size_t from, size_t to) {
+		List& source = mLists[from];
+		if(source.mHead == NIL) {
+			return;
+		}
+		for(size_t i = source.mHead; i != NIL; i = mNodes[i].mNext) {
+			mNodes[i].mList = to;
+		}
+		List& dest = mLists[to];
+		if(dest.mTail == NIL) {
+			dest.mHead = source.mHead;
+		} else {
+			mNodes[dest.mTail].mNext = source.mHead;
+			mNodes[source.mHead].mPrev = dest.mTail;
+		}
+		dest.mTail = source.mTail;
+		source.mHead = NIL;
+		source.mTail = NIL;
+	}
+};
+
+#endif /* TIMERSCHEDULER_H_ */
@@ -0,0 +1,181 @@
+/*
+ * NameArena.hpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef NAMEARENA_H_
+#define NAMEARENA_H_
+
+#include <cstdint>
+using std::uint32_t;
+#include <cstring>
+using std::memcpy;
+#include <functional>
+#include <limits>
+using std::numeric_limits;
+#include <memory>
+using std::unique_ptr;
+#include <stdexcept>
+using std::length_error;
+#include <string_view>
+using std::string_view;
+#include <vector>
+using std::vector;
+
+/**
+ * Interns strings into large chunks of memory and hands out 32-bit handles
+ * to them.
+ *
+ * Storing a handle instead of a `shared_ptr<string>` per item saves two
+ * allocations and the reference counting per string, and shrinks the item
+ * to 4 bytes. The characters of all the strings are packed back to back in
+ * chunks of `CHUNK_SIZE` bytes, and an equal string interned twice gets the
+ * same handle. Nothing is freed until the arena is cleared or destroyed,
+ * which releases everything at once.
+ *
+ * Views returned by `name()` stay valid until then, since chunks never move.
+ */
+class NameArena {
+public:
+	typedef uint32_t Handle;
+
+	// The bytes allocated at a time for characters
+	static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+	NameArena() : mCursor(nullptr), mChunkEnd(nullptr) {}
+
+	NameArena(const NameArena&) = delete;
+	NameArena& operator=(const NameArena&) = delete;
+
+	/**
+	 * Returns the handle of a string equal to `text`, copying `text` into
+	 * the arena if it's new.
+	 *
+	 * This is a constant time operation on average, plus the copy.
+	 *
+	 * @param text - the string to intern
+	 * @throws length_error if the arena already holds as many strings as a
+	 *         handle can number
+	 */
+	Handle intern(string_view text) {
+		if(2 * (mNames.size() + 1) > mSlots.size()) {
+			rehash(mSlots.empty() ? MIN_SLOTS : 2 * mSlots.size());
+		}
+		size_t slot = findSlot(text);
+		if(mSlots[slot] != EMPTY) {
+			return mSlots[slot];
+		}
+		if(mNames.size() == EMPTY) {
+			throw length_error("NameArena is out of handles.");
+		}
+
+		Handle handle = static_cast<Handle>(mNames.size());
+		mNames.push_back(copy(text));
+		mSlots[slot] = handle;
+		return handle;
+	}
+
+	/**
+	 * Returns the string interned as `handle`.
+	 *
+	 * Calling this function with a handle this arena didn't hand out causes
+	 * undefined behavior.
+	 */
+	string_view name(Handle handle) const {
+		return mNames[handle];
+	}
+
+	/**
+	 * Frees every string at once. Handles and views handed out so far
+	 * become invalid.
+	 */
+	void clear() {
+		mChunks.clear();
+		vector<string_view>().swap(mNames);
+		vector<Handle>().swap(mSlots);
+		mCursor = mChunkEnd = nullptr;
+	}
+
+	/**
+	 * Returns the number of distinct strings interned.
+	 */
+	const size_t getSize() const {
+		return mNames.size();
+	}
+
+	/**
+	 * Returns the bytes allocated for characters, the handle table and the
+	 * hash table.
+	 */
+	size_t getBytesAllocated() const {
+		size_t bytes = mNames.capacity() * sizeof(string_view)
+				+ mSlots.capacity() * sizeof(Handle);
+		for(const Chunk& chunk : mChunks) {
+			bytes += chunk.mSize;
+		}
+		return bytes;
+	}
+
+private:
+	struct Chunk {
+		unique_ptr<char[]> mData;
+		size_t mSize;
+	};
+
+	// Marks an empty slot in the hash table; also one past the last handle
+	static constexpr Handle EMPTY = numeric_limits<Handle>::max();
+	static constexpr size_t MIN_SLOTS = 64;
+
+	vector<Chunk> mChunks;
+	char* mCursor; // the next free byte in the last chunk
+	char* mChunkEnd;
+	vector<string_view> mNames; // the strings, by handle
+	vector<Handle> mSlots; // an open-addressing hash table of handles
+
+	/**
+	 * Copies `text` into the current chunk, starting a new one if it
+	 * doesn't fit, and returns the copy.
+	 */
+	string_view copy(string_view text) {
+		if(static_cast<size_t>(mChunkEnd - mCursor) < text.size()) {
+			// Long strings get a chunk of their own
+			size_t size = (text.size() > CHUNK_SIZE) ? text.size() : CHUNK_SIZE;
+			mChunks.push_back(Chunk { unique_ptr<char[]>(new char[size]), size });
+			mCursor = mChunks.back().mData.get();
+			mChunkEnd = mCursor + size;
+		}
+		char* start = mCursor;
+		if(!text.empty()) {
+			memcpy(start, text.data(), text.size());
+		}
+		mCursor += text.size();
+		return string_view(start, text.size());
+	}
+
+	/**
+	 * Returns the slot holding a string equal to `text`, or the empty slot
+	 * where it belongs. `mSlots` must have an empty slot.
+	 */
+	size_t findSlot(string_view text) const {
+		size_t mask = mSlots.size() - 1;
+		size_t slot = std::hash<string_view>()(text) & mask;
+		while(mSlots[slot] != EMPTY && mNames[mSlots[slot]] != text) {
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+
+	/**
+	 * Resizes the hash table to `numSlots`, a power of 2, and reinserts
+	 * every handle.
+	 */
+	void rehash(size_t numSlots) {
+		mSlots.assign(numSlots, EMPTY);
+		for(size_t handle = 0; handle < mNames.size(); handle++) {
+			mSlots[findSlot(mNames[handle])] = static_cast<Handle>(handle);
+		}
+	}
+};
+
+#endif /* NAMEARENA_H_ */
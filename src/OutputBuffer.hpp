@@ -0,0 +1,168 @@
+/*
+ * OutputBuffer.hpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OUTPUTBUFFER_H_
+#define OUTPUTBUFFER_H_
+
+#include <cerrno>
+#include <charconv>
+using std::to_chars;
+#include <chrono>
+#include <cstring>
+using std::memcpy;
+#include <memory>
+using std::unique_ptr;
+#include <string_view>
+using std::string_view;
+#include <type_traits>
+
+#include <unistd.h>
+
+/**
+ * Collects output in one large buffer and writes it to a file descriptor
+ * when the buffer fills up, on `flush()`, and on destruction.
+ *
+ * Writing a line with `cout << ... << endl` flushes it, which is a system
+ * call per line. Here, lines only reach the file descriptor a buffer at a
+ * time. For interactive use, `lineFlush` writes every line out as soon as
+ * it ends, like `endl`.
+ *
+ * The time spent writing is added up in `getWriteTime()`, so callers can
+ * tell it apart from their own work.
+ */
+class OutputBuffer {
+public:
+	typedef std::chrono::steady_clock::duration Duration;
+
+	// The default buffer size, in bytes
+	static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+	/**
+	 * Constructs an OutputBuffer.
+	 *
+	 * @param fd - the file descriptor to write to
+	 * @param lineFlush - if true, write out every line as soon as it ends
+	 * @param capacity - the size of the buffer, in bytes
+	 */
+	explicit OutputBuffer(int fd=STDOUT_FILENO, bool lineFlush=false,
+			size_t capacity=DEFAULT_CAPACITY)
+		: mBuffer(new char[capacity]),
+		  mCapacity(capacity),
+		  mSize(0),
+		  mFd(fd),
+		  mLineFlush(lineFlush),
+		  mFailed(false),
+		  mWriteTime(Duration::zero())
+	{}
+
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+	/// Destructor. Writes out whatever is left.
+	~OutputBuffer() {
+		flush();
+	}
+
+	OutputBuffer& operator<<(string_view text) {
+		if(text.size() > mCapacity - mSize) {
+			flush();
+			if(text.size() > mCapacity) {
+				// Too big to buffer; write it straight out
+				writeOut(text.data(), text.size());
+				return *this;
+			}
+		}
+		memcpy(mBuffer.get() + mSize, text.data(), text.size());
+		mSize += text.size();
+		return *this;
+	}
+
+	OutputBuffer& operator<<(const char* text) {
+		return *this << string_view(text);
+	}
+
+	/**
+	 * Appends `c`. A newline ends the line, which is written out right away
+	 * in line-flush mode.
+	 */
+	OutputBuffer& operator<<(char c) {
+		if(mSize == mCapacity) {
+			flush();
+		}
+		mBuffer[mSize++] = c;
+		if(c == '\n' && mLineFlush) {
+			flush();
+		}
+		return *this;
+	}
+
+	/**
+	 * Appends the decimal digits of `number`.
+	 */
+	template<class Integer, class = typename std::enable_if<
+			std::is_integral<Integer>::value>::type>
+	OutputBuffer& operator<<(Integer number) {
+		char digits[24];
+		char* end = to_chars(digits, digits + sizeof(digits), number).ptr;
+		return *this << string_view(digits, end - digits);
+	}
+
+	/**
+	 * Writes out everything buffered so far.
+	 */
+	void flush() {
+		if(mSize > 0) {
+			writeOut(mBuffer.get(), mSize);
+			mSize = 0;
+		}
+	}
+
+	/**
+	 * Returns true if a write has failed. Output is dropped from then on.
+	 */
+	bool failed() const {
+		return mFailed;
+	}
+
+	/**
+	 * Returns the total time spent writing to the file descriptor.
+	 */
+	Duration getWriteTime() const {
+		return mWriteTime;
+	}
+
+private:
+	unique_ptr<char[]> mBuffer;
+	size_t mCapacity;
+	size_t mSize; // the bytes buffered
+	int mFd;
+	bool mLineFlush;
+	bool mFailed;
+	Duration mWriteTime;
+
+	/**
+	 * Writes all of `[data, data + size)` to the file descriptor, unless a
+	 * write has failed.
+	 */
+	void writeOut(const char* data, size_t size) {
+		std::chrono::steady_clock::time_point start =
+				std::chrono::steady_clock::now();
+		while(size > 0 && !mFailed) {
+			ssize_t written = ::write(mFd, data, size);
+			if(written < 0) {
+				if(errno != EINTR) {
+					mFailed = true;
+				}
+				continue;
+			}
+			data += written;
+			size -= written;
+		}
+		mWriteTime += std::chrono::steady_clock::now() - start;
+	}
+};
+
+#endif /* OUTPUTBUFFER_H_ */
@@ -3,9 +3,6 @@ using std::cout;
 using std::cerr;
 using std::cin;
 using std::endl;
-#include <iomanip>
-using std::setw;
-using std::setfill;
 #include <string>
 using std::string;
 using std::stoi;
@@ -15,6 +12,14 @@ using std::invalid_argument;
 using std::out_of_range;
 #include <cstring>
 using std::strlen;
+using std::memchr;
+#include <cctype>
+#include <charconv>
+using std::from_chars;
+#include <string_view>
+using std::string_view;
+#include <system_error>
+using std::errc;
 #include <sstream>
 using std::stringstream;
 using std::istringstream;
@@ -26,10 +31,31 @@ using std::chrono::duration;
 using std::chrono::steady_clock;
 #include <exception>
 using std::exception;
-#include <memory>
-using std::shared_ptr;
+#include <vector>
+using std::vector;
+#include <utility>
+using std::pair;
+#include <iterator>
+#include <thread>
+using std::thread;
+#include <future>
+using std::promise;
+using std::future;
+#include <mutex>
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+#include <condition_variable>
+using std::condition_variable;
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "PriorityQueue.hpp"
+#include "NameArena.hpp"
+#include "OutputBuffer.hpp"
 
 /**
  * Functions for running sportsball
@@ -42,6 +68,13 @@ static const int MILLIS_PER_SECOND = 1000;
 static const string SUB_PLAYER_TOKEN = "GO!";
 static const char INLINE_DELIMITER = '/';
 static const string TITLE = "SPORTSBALL!";
+static const string MMAP_FLAG = "--mmap";
+static const string LINE_FLUSH_FLAG = "--line-flush";
+static const string PARALLEL_FLAG = "--parallel";
+// The most bytes of the data file parsed in one batch in parallel mode
+static const size_t PARSE_CHUNK_SIZE = 256 * 1024;
+// How many chunks per thread workers may parse ahead of the game
+static const size_t PARSE_WINDOW = 2;
 
 /**
  * Returns this programs help string.
@@ -49,18 +82,378 @@ static const string TITLE = "SPORTSBALL!";
  * @param programName - name to display in `Usage: programName...etc`
  */
 string helpstr(string programName) {
-	return "Usage: " + programName + " dataFile [initialSize] [stepSize]\n" +
+	return "Usage: " + programName +
+			" [--mmap | --parallel] [--line-flush] dataFile [initialSize]" +
+			" [stepSize]\n" +
 			"mandatory arguments: \n"
 			"\n\tdataFile - string, path to a data file wherein each line " +
 			" contains a space-separated pair of connected node ids" +
 			"\noptional arguments:" +
+			"\n\t--mmap - memory-map the data file instead of streaming it." +
+			"\n\t--parallel - memory-map the data file and parse it on " +
+			"several threads." +
+			"\n\t--line-flush - write each line out as soon as it's done, " +
+			"for watching interactively." +
 			"\n\tinitialCapacity - size_t, number of elements the queue should" +
 			"should support before the first resize." +
 			"\n\tstepSize - size_t, number of elements by which to increase the" +
 			"size of the queue when the allocated size is exceeded.";
 }
 
-int playBall(string dataFile, size_t initialCapacity, size_t stepSize) {
+/**
+ * Writes the title banner to `out`.
+ */
+void printTitle(OutputBuffer& out) {
+	int pad = 80 - TITLE.size() - 5;
+	out << string(3, '#') << ' ' << TITLE << ' ' << string(pad, '#') << '\n';
+}
+
+/**
+ * Writes what's left in `playerQueue` at the end of the game to `out`.
+ */
+template<class Queue>
+void printSummary(OutputBuffer& out, const Queue& playerQueue) {
+	out << string(80, '-') << '\n';
+	out << "At the end, there were " << playerQueue.getSize()
+			<< " players left." << '\n';
+	out << "The array was resized " << playerQueue.getNumResizes()
+			<< " times." << '\n';
+}
+
+/**
+ * A read-only memory mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile {
+public:
+	/**
+	 * Maps `path`. Check `is_open()` to see if that worked.
+	 */
+	explicit MappedFile(const string& path) : mData(nullptr), mSize(0),
+			mOpen(false) {
+		int fd = open(path.c_str(), O_RDONLY);
+		if(fd < 0) {
+			return;
+		}
+		struct stat info;
+		if(fstat(fd, &info) == 0) {
+			mSize = info.st_size;
+			if(mSize == 0) {
+				mOpen = true; // nothing to map
+			} else {
+				void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(data != MAP_FAILED) {
+					// We read it front to back, once
+					madvise(data, mSize, MADV_SEQUENTIAL);
+					mData = static_cast<const char*>(data);
+					mOpen = true;
+				}
+			}
+		}
+		close(fd);
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() {
+		if(mData != nullptr) {
+			munmap(const_cast<char*>(mData), mSize);
+		}
+	}
+
+	bool is_open() const {
+		return mOpen;
+	}
+
+	const char* begin() const {
+		return mData;
+	}
+
+	const char* end() const {
+		return mData + mSize;
+	}
+
+private:
+	const char* mData;
+	size_t mSize;
+	bool mOpen;
+};
+
+/**
+ * Parses a priority the way `stoi` does (leading whitespace and a `+` are
+ * fine, and so is anything after the digits), with `from_chars`. Errors
+ * carry `stoi`'s message too, so both ingest modes report them alike.
+ *
+ * @throws invalid_argument if there's no number
+ * @throws out_of_range if the number doesn't fit in an `int`
+ */
+int parsePriority(string_view text) {
+	size_t begin = 0;
+	while(begin < text.size()
+			&& std::isspace(static_cast<unsigned char>(text[begin]))) {
+		begin++;
+	}
+	if(begin + 1 < text.size() && text[begin] == '+'
+			&& std::isdigit(static_cast<unsigned char>(text[begin + 1]))) {
+		begin++;
+	}
+
+	int priority = 0;
+	const char* first = text.data() + begin;
+	const char* last = text.data() + text.size();
+	errc error = from_chars(first, last, priority).ec;
+	if(error == errc::invalid_argument) {
+		throw invalid_argument("stoi");
+	} else if(error == errc::result_out_of_range) {
+		throw out_of_range("stoi");
+	}
+	return priority;
+}
+
+/**
+ * Returns the line starting at `cursor`, without its newline, and moves
+ * `cursor` to the start of the next one. Like `getline`, the last line
+ * needn't end in a newline.
+ */
+string_view nextLine(const char*& cursor, const char* end) {
+	const char* newline =
+			static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+	const char* lineEnd = (newline != nullptr) ? newline : end;
+	string_view line(cursor, lineEnd - cursor);
+	cursor = (newline != nullptr) ? newline + 1 : end;
+	return line;
+}
+
+/**
+ * Splits a player's `line` at our delimiter into their name and the text
+ * of their priority, which is empty if there's no delimiter.
+ */
+pair<string_view, string_view> splitPlayer(string_view line) {
+	size_t delimiter = line.find(INLINE_DELIMITER);
+	if(delimiter == string_view::npos) {
+		return pair<string_view, string_view>(line, string_view());
+	}
+	return pair<string_view, string_view>(line.substr(0, delimiter),
+			line.substr(delimiter + 1));
+}
+
+/**
+ * One line of a data file, parsed.
+ */
+struct Play {
+	enum Kind {
+		PLAYER, // a player to queue
+		SUB, // a `GO!`
+		BAD_PRIORITY, // a player whose priority isn't a number
+		PRIORITY_OUT_OF_RANGE // a player whose priority doesn't fit
+	};
+
+	Kind mKind;
+	string_view mName;
+	int mPriority;
+};
+
+/**
+ * The plays parsed from a chunk of a data file.
+ */
+struct PlayBatch {
+	vector<Play> mPlays;
+	// The lines parsed. Parsing stops at a bad priority, which is then the
+	// last play and the last line counted.
+	size_t mNumLines;
+};
+
+/**
+ * Parses the lines in `[cursor, end)` into a batch of plays.
+ */
+PlayBatch parsePlays(const char* cursor, const char* end) {
+	PlayBatch batch;
+	batch.mNumLines = 0;
+	while(cursor != end) {
+		string_view line = nextLine(cursor, end);
+		batch.mNumLines++;
+
+		if(line == SUB_PLAYER_TOKEN) {
+			batch.mPlays.push_back(Play { Play::SUB, string_view(), 0 });
+			continue;
+		}
+
+		pair<string_view, string_view> player = splitPlayer(line);
+		try {
+			batch.mPlays.push_back(Play { Play::PLAYER, player.first,
+					parsePriority(player.second) });
+		} catch(invalid_argument& e) {
+			batch.mPlays.push_back(Play { Play::BAD_PRIORITY, player.first, 0 });
+			break;
+		} catch(out_of_range& e) {
+			batch.mPlays.push_back(
+					Play { Play::PRIORITY_OUT_OF_RANGE, player.first, 0 });
+			break;
+		}
+	}
+	return batch;
+}
+
+/**
+ * Parses a memory-mapped data file into `PlayBatch`es on worker threads.
+ *
+ * The file is cut into chunks of about `PARSE_CHUNK_SIZE` bytes at line
+ * boundaries. Workers parse the chunks in file order and `take()` hands
+ * them over in that order. Workers only run `PARSE_WINDOW` chunks per
+ * thread ahead of the reader, and wait for `take()` to catch up, so a big
+ * file's plays are never all in memory at once. The workers are stopped
+ * and joined on destruction.
+ */
+class PlayParser {
+public:
+	/**
+	 * Starts parsing `[begin, end)` on `numThreads` threads.
+	 */
+	PlayParser(const char* begin, const char* end, size_t numThreads)
+		: mWindow(PARSE_WINDOW * numThreads),
+		  mNextChunk(0),
+		  mNextTaken(0),
+		  mStopped(false)
+	{
+		mBounds.push_back(begin);
+		while(end - mBounds.back() > static_cast<ptrdiff_t>(PARSE_CHUNK_SIZE)) {
+			const char* cursor = mBounds.back() + PARSE_CHUNK_SIZE;
+			nextLine(cursor, end); // finish the line we landed in
+			mBounds.push_back(cursor);
+		}
+		if(mBounds.back() != end) {
+			mBounds.push_back(end);
+		}
+
+		mBatches.resize(getNumChunks());
+		mResults.reserve(getNumChunks());
+		for(promise<PlayBatch>& batch : mBatches) {
+			mResults.push_back(batch.get_future());
+		}
+
+		for(size_t i = 0; i < numThreads && i < getNumChunks(); i++) {
+			mWorkers.push_back(thread(&PlayParser::work, this));
+		}
+	}
+
+	PlayParser(const PlayParser&) = delete;
+	PlayParser& operator=(const PlayParser&) = delete;
+
+	/// Destructor. Stops parsing and waits for the workers.
+	~PlayParser() {
+		{
+			lock_guard<mutex> lock(mMutex);
+			mStopped = true;
+		}
+		mTaken.notify_all();
+		for(thread& worker : mWorkers) {
+			worker.join();
+		}
+	}
+
+	/**
+	 * Returns the number of chunks, and so of batches, in the file.
+	 */
+	size_t getNumChunks() const {
+		return mBounds.size() - 1;
+	}
+
+	/**
+	 * Returns the batch parsed from chunk `i`, waiting for it if needed.
+	 * Batches must be taken in order, each once.
+	 */
+	PlayBatch take(size_t i) {
+		{
+			// Moves the window along, so workers can start on the next chunk
+			lock_guard<mutex> lock(mMutex);
+			mNextTaken = i + 1;
+		}
+		mTaken.notify_all();
+		return mResults[i].get();
+	}
+
+private:
+	vector<const char*> mBounds; // chunk `i` is [mBounds[i], mBounds[i + 1])
+	vector<promise<PlayBatch> > mBatches;
+	vector<future<PlayBatch> > mResults;
+	size_t mWindow; // how many chunks past the reader workers may parse
+	mutex mMutex; // guards the members below
+	condition_variable mTaken; // signalled when the window moves or we stop
+	size_t mNextChunk; // the next chunk a worker should parse
+	size_t mNextTaken; // the next chunk `take()` will hand over
+	bool mStopped;
+	vector<thread> mWorkers;
+
+	/**
+	 * Parses chunks, in order, until there are none left or we're stopped.
+	 */
+	void work() {
+		while(true) {
+			size_t i;
+			{
+				unique_lock<mutex> lock(mMutex);
+				mTaken.wait(lock, [this] {
+					return mStopped || mNextChunk >= getNumChunks()
+							|| mNextChunk < mNextTaken + mWindow;
+				});
+				if(mStopped || mNextChunk >= getNumChunks()) {
+					return;
+				}
+				i = mNextChunk++;
+			}
+			try {
+				mBatches[i].set_value(parsePlays(mBounds[i], mBounds[i + 1]));
+			} catch(...) {
+				mBatches[i].set_exception(std::current_exception());
+			}
+		}
+	}
+};
+
+/**
+ * Iterates over a run of `PLAYER` plays as (name, priority) entries for
+ * `PriorityQueue::insert_range()`.
+ *
+ * It's an input iterator, so the queue grows one step at a time as single
+ * inserts would make it. The resize count we print at the end then comes
+ * out the same in every mode.
+ */
+class PlayerEntries {
+public:
+	typedef std::input_iterator_tag iterator_category;
+	typedef pair<string_view, int> value_type;
+	typedef ptrdiff_t difference_type;
+	typedef const value_type* pointer;
+	typedef value_type reference;
+
+	explicit PlayerEntries(const Play* play) : mPlay(play) {}
+
+	value_type operator*() const {
+		return value_type(mPlay->mName, mPlay->mPriority);
+	}
+
+	PlayerEntries& operator++() {
+		++mPlay;
+		return *this;
+	}
+
+	bool operator==(const PlayerEntries& rhs) const {
+		return mPlay == rhs.mPlay;
+	}
+
+	bool operator!=(const PlayerEntries& rhs) const {
+		return mPlay != rhs.mPlay;
+	}
+
+private:
+	const Play* mPlay;
+};
+
+/**
+ * Plays the game in `dataFile`, writing the play-by-play to `out`.
+ */
+int playBall(OutputBuffer& out, string dataFile, size_t initialCapacity,
+		size_t stepSize) {
 	int returnVal = 1;  // pessimism to boot
 
 	// File input based on example here:
@@ -71,17 +464,16 @@ int playBall(string dataFile, size_t initialCapacity, size_t stepSize) {
 
 		// Fail if we can't open the file.
 		if(!infile.is_open()) {
-			cout << "File could not be opened." << endl;
+			out << "File could not be opened." << '\n';
 			returnVal = 1;
 		} else {
-			int pad = 80 - TITLE.size() - 5;
-			cout << setfill('#') << setw(4) << " "
-					<< TITLE
-					<< " " << setfill('#') <<  setw(pad) << "#" << endl;
+			printTitle(out);
 
-			PriorityQueue<shared_ptr<string> >
+			// Names live in the arena; the queue only holds their handles
+			NameArena names;
+			PriorityQueue<NameArena::Handle>
 				playerQueue(initialCapacity, stepSize);
-			string line, priorityString;
+			string line, name, priorityString;
 			int priority = 0;
 			int lineNumber = 0;
 			istringstream lineStream;
@@ -92,21 +484,18 @@ int playBall(string dataFile, size_t initialCapacity, size_t stepSize) {
 					// If there is a player to poll
 					if(!playerQueue.empty()) {
 						// Print their name
-						shared_ptr<string> pName = playerQueue.top();
-						cout << *pName << " enters the game." << endl;
-						playerQueue.pop();
-						//pName.reset(); // discard our pointer to the string
+						NameArena::Handle player = playerQueue.pop_value();
+						out << names.name(player) << " enters the game."
+								<< '\n';
 					} else {
-						cout << "No one is ready!" << endl;
+						out << "No one is ready!" << '\n';
 					}
 				} else {
 					lineStream.str(line); // replace the current string
 					lineStream.clear(); // reset flags
 
-					std::shared_ptr<std::string> pName(new string);
-
 					// We can use getLine to parse up to our delimiter
-					getline(lineStream, *pName, INLINE_DELIMITER);
+					getline(lineStream, name, INLINE_DELIMITER);
 					// Then extract the rest of the line normally
 					getline(lineStream, priorityString);
 
@@ -114,53 +503,52 @@ int playBall(string dataFile, size_t initialCapacity, size_t stepSize) {
 					try {
 						priority = stoi(priorityString);
 					} catch(invalid_argument& e) {
-						cout << "There was a problem reading in the priority"
+						out << "There was a problem reading in the priority"
 								<< " on line "
-								<< (lineNumber + 1) << "." << endl;
+								<< (lineNumber + 1) << "." << '\n';
 						throw e; // we catch invalid_argument again later
 					} catch (out_of_range& e) {
-						cout << "There was a problem reading in the priority"
+						out << "There was a problem reading in the priority"
 								<< " on line "
-								<< (lineNumber + 1) << "." << endl;
+								<< (lineNumber + 1) << "." << '\n';
 
 						throw e; // we catch out_of_range again later
 					}
 
+					NameArena::Handle player = names.intern(name);
+
 					if(sportsball::DEBUG) {
-						cout << "Inserting " << *pName << "/"
-							<< priority << " (@" << pName << ")" << endl;
+						out << "Inserting " << name << "/"
+							<< priority << " (#" << player << ")" << '\n';
 					}
 
 					// Cool. That worked. Now queue the player.
-					playerQueue.insert(pName, priority);
-					pName.reset();
+					playerQueue.insert(player, priority);
 					priorityString.clear();
 				}
 
 				if(sportsball::DEBUG) {
-					cout << "size: " << playerQueue.getSize() << "; "
+					out << "size: " << playerQueue.getSize() << "; "
 							<< "capacity: "
 							<< playerQueue.getCapacity() << "; "
 							<< "numResizes: "
-							<< playerQueue.getNumResizes() << "." << endl;
+							<< playerQueue.getNumResizes() << "; "
+							<< "nameBytes: "
+							<< names.getBytesAllocated() << "." << '\n';
 				}
 
 				lineNumber++; // track line number
 			}
 
-			cout << setfill('-') << setw(80) << "-" <<endl;
-			cout << "At the end, there were " << playerQueue.getSize()
-					<< " players left." << endl;
-			cout << "The array was resized " << playerQueue.getNumResizes()
-					<< " times." << endl;
+			printSummary(out, playerQueue);
 
 			returnVal = 0;
 		}
 
 	} catch(invalid_argument& e) {
-		cout << "Error:" << e.what() << endl;
+		out << "Error:" << e.what() << '\n';
 	} catch (out_of_range& e) {
-		cout << "Error: " << e.what() << endl;
+		out << "Error: " << e.what() << '\n';
 	}
 
 	infile.close();
@@ -168,6 +556,162 @@ int playBall(string dataFile, size_t initialCapacity, size_t stepSize) {
 	return returnVal;
 }
 
+/**
+ * Plays like `playBall()`, but memory-maps `dataFile` and scans it in
+ * place: lines are found with `memchr`, and the players queued are
+ * `string_view`s into the mapping, so nothing is copied or allocated per
+ * line.
+ */
+int playBallMapped(OutputBuffer& out, string dataFile,
+		size_t initialCapacity, size_t stepSize) {
+	int returnVal = 1;  // pessimism to boot
+
+	MappedFile file(dataFile);
+
+	try {
+
+		// Fail if we can't open the file.
+		if(!file.is_open()) {
+			out << "File could not be opened." << '\n';
+			returnVal = 1;
+		} else {
+			printTitle(out);
+
+			PriorityQueue<string_view> playerQueue(initialCapacity, stepSize);
+			int lineNumber = 0;
+
+			// For each line in the file
+			const char* cursor = file.begin();
+			while(cursor != file.end()) {
+				string_view line = nextLine(cursor, file.end());
+
+				if(line == SUB_PLAYER_TOKEN) {
+					// If there is a player to poll
+					if(!playerQueue.empty()) {
+						// Print their name
+						out << playerQueue.pop_value() << " enters the game."
+								<< '\n';
+					} else {
+						out << "No one is ready!" << '\n';
+					}
+				} else {
+					// The name runs up to our delimiter, the priority after it
+					pair<string_view, string_view> player = splitPlayer(line);
+
+					int priority = 0;
+					try {
+						priority = parsePriority(player.second);
+					} catch(exception& e) {
+						out << "There was a problem reading in the priority"
+								<< " on line "
+								<< (lineNumber + 1) << "." << '\n';
+						throw; // we catch it again later
+					}
+
+					playerQueue.insert(player.first, priority);
+				}
+
+				lineNumber++; // track line number
+			}
+
+			printSummary(out, playerQueue);
+
+			returnVal = 0;
+		}
+
+	} catch(invalid_argument& e) {
+		out << "Error:" << e.what() << '\n';
+	} catch (out_of_range& e) {
+		out << "Error: " << e.what() << '\n';
+	}
+
+	return returnVal;
+}
+
+/**
+ * Plays like `playBallMapped()`, but parses the file on `numThreads` worker
+ * threads while this one runs the game.
+ *
+ * The only order that matters is that of the `GO!`s, so the players between
+ * two of them are queued together with `insert_range()`. Their ids, and so
+ * the order ties leave in, are the same as if they'd been inserted one at a
+ * time, and so is the output.
+ */
+int playBallParallel(OutputBuffer& out, string dataFile,
+		size_t initialCapacity, size_t stepSize, size_t numThreads) {
+	int returnVal = 1;  // pessimism to boot
+
+	MappedFile file(dataFile);
+
+	try {
+
+		// Fail if we can't open the file.
+		if(!file.is_open()) {
+			out << "File could not be opened." << '\n';
+			returnVal = 1;
+		} else {
+			printTitle(out);
+
+			PriorityQueue<string_view> playerQueue(initialCapacity, stepSize);
+			size_t lineNumber = 0;
+			PlayParser parser(file.begin(), file.end(), numThreads);
+
+			// For each batch of lines in the file
+			for(size_t chunk = 0; chunk < parser.getNumChunks(); chunk++) {
+				PlayBatch batch = parser.take(chunk);
+				const Play* plays = batch.mPlays.data();
+				size_t runStart = 0;
+
+				for(size_t i = 0; i < batch.mPlays.size(); i++) {
+					if(plays[i].mKind == Play::PLAYER) {
+						continue;
+					}
+
+					// Queue the players since the last `GO!` all at once
+					playerQueue.insert_range(PlayerEntries(plays + runStart),
+							PlayerEntries(plays + i));
+					runStart = i + 1;
+
+					if(plays[i].mKind == Play::SUB) {
+						// If there is a player to poll
+						if(!playerQueue.empty()) {
+							// Print their name
+							out << playerQueue.pop_value()
+									<< " enters the game." << '\n';
+						} else {
+							out << "No one is ready!" << '\n';
+						}
+					} else {
+						// The bad line is the last one of the batch
+						out << "There was a problem reading in the priority"
+								<< " on line "
+								<< (lineNumber + batch.mNumLines) << "." << '\n';
+						if(plays[i].mKind == Play::BAD_PRIORITY) {
+							throw invalid_argument("stoi");
+						}
+						throw out_of_range("stoi");
+					}
+				}
+				playerQueue.insert_range(PlayerEntries(plays + runStart),
+						PlayerEntries(plays + batch.mPlays.size()));
+
+				lineNumber += batch.mNumLines;
+			}
+
+			printSummary(out, playerQueue);
+
+			returnVal = 0;
+		}
+
+	} catch(invalid_argument& e) {
+		out << "Error:" << e.what() << '\n';
+	} catch (out_of_range& e) {
+		out << "Error: " << e.what() << '\n';
+	}
+
+	return returnVal;
+}
+
 } /* End namespace sportsball*/
 
 /**
@@ -182,6 +726,28 @@ int main(int argc, const char* argv[]) {
 
 	int returnVal = 1; // assume error will occur
 
+	// Take out the flags, wherever they are, before counting arguments
+	bool mapped = false;
+	bool parallel = false;
+	bool lineFlush = false;
+	vector<const char*> args;
+	for(int i = 0; i < argc; i++) {
+		if(i > 0 && argv[i] == sportsball::MMAP_FLAG) {
+			mapped = true;
+		} else if(i > 0 && argv[i] == sportsball::PARALLEL_FLAG) {
+			parallel = true;
+		} else if(i > 0 && argv[i] == sportsball::LINE_FLUSH_FLAG) {
+			lineFlush = true;
+		} else {
+			args.push_back(argv[i]);
+		}
+	}
+	argc = args.size();
+	argv = args.data();
+
+	// The game's output is buffered, and only written out in bulk
+	OutputBuffer out(STDOUT_FILENO, lineFlush);
+
 	const int requiredArgs = 1;
 	const int optionalArgs = 2;
 	const int maxArgs = 1 + requiredArgs + optionalArgs;
@@ -224,7 +790,19 @@ int main(int argc, const char* argv[]) {
 						string(" unsigned parameter."));
 
 			// Run the game and capture result
-			returnVal = sportsball::playBall(dataFile, initialSize, stepSize);
+			if(parallel) {
+				// Leave a core for the game itself
+				size_t numThreads = thread::hardware_concurrency();
+				numThreads = (numThreads > 2) ? numThreads - 1 : 1;
+				returnVal = sportsball::playBallParallel(out, dataFile,
+						initialSize, stepSize, numThreads);
+			} else if(mapped) {
+				returnVal = sportsball::playBallMapped(out, dataFile,
+						initialSize, stepSize);
+			} else {
+				returnVal = sportsball::playBall(out, dataFile, initialSize,
+						stepSize);
+			}
 
 		} catch(invalid_argument& e) {
 			cout << "You entered a non-numeric value for a numeric parameter."
@@ -245,8 +823,10 @@ int main(int argc, const char* argv[]) {
 	// Capture end time
 	end = steady_clock::now();
 
-	// Compute and print elapsed
-	duration<double> elapsed = end-start;
+	// Compute and print elapsed, leaving out the time spent writing so it
+	// measures the game rather than the terminal
+	duration<double> elapsed = end-start - out.getWriteTime();
+	out.flush();
 	double elapsedMillis = elapsed.count() * sportsball::MILLIS_PER_SECOND;
 	cout << "Elapsed " <<  elapsedMillis << "ms." << endl;
 
@@ -0,0 +1,964 @@
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <vector>
+using std::vector;
+#include <set>
+using std::multiset;
+#include <utility>
+using std::pair;
+#include <random>
+using std::mt19937;
+using std::uniform_int_distribution;
+#include <chrono>
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+#include <stdexcept>
+using std::out_of_range;
+using std::runtime_error;
+#include <algorithm>
+using std::sort;
+using std::stable_sort;
+#include <iterator>
+using std::back_inserter;
+#include <functional>
+#include <future>
+using std::async;
+using std::future;
+using std::future_status;
+#include <thread>
+using std::thread;
+#include <atomic>
+using std::atomic;
+#include <cassert>
+#include <cstdint>
+
+#include "PriorityQueue.hpp"
+#include "StaticPriorityQueue.hpp"
+#include "MinMaxPriorityQueue.hpp"
+#include "BoundedPriorityQueue.hpp"
+#include "BucketQueue.hpp"
+#include "RadixHeap.hpp"
+#include "TimerScheduler.hpp"
+#include "MultiQueue.hpp"
+#include "BlockingPriorityQueue.hpp"
+
+/**
+ * Correctness tests for the queues. Every check is a plain `assert`, so
+ * the first failure aborts with its line number.
+ */
+namespace test {
+
+//------------------------------------------------------------------------------
+// HANDLES
+//------------------------------------------------------------------------------
+
+/**
+ * What an item in the queue should look like: its priority, and the order
+ * it was inserted in, which breaks ties first-in, first-out.
+ */
+struct Expected {
+	int mPriority;
+	size_t mOrder;
+	int mItem;
+};
+
+/**
+ * True if `a` should leave a highest-first queue before `b`.
+ */
+bool before(const Expected& a, const Expected& b) {
+	if(a.mPriority != b.mPriority) {
+		return a.mPriority > b.mPriority;
+	}
+	return a.mOrder < b.mOrder;
+}
+
+/**
+ * Checks that `handle` finds nothing and that every handle operation
+ * rejects it.
+ */
+template<class Queue>
+void assertStale(Queue& queue, typename Queue::Handle handle) {
+	assert(!queue.contains(handle));
+	bool threw = false;
+	try {
+		queue.update(handle, 0);
+	} catch(const out_of_range&) {
+		threw = true;
+	}
+	assert(threw);
+	threw = false;
+	try {
+		queue.erase(handle);
+	} catch(const out_of_range&) {
+		threw = true;
+	}
+	assert(threw);
+	threw = false;
+	try {
+		queue.cancel(handle);
+	} catch(const out_of_range&) {
+		threw = true;
+	}
+	assert(threw);
+}
+
+/**
+ * Runs random inserts, pops, updates, erases and cancels on `queue` and on
+ * a plain vector of what it should hold. Every pop must return the item the
+ * vector says is best, every handle of an item that left must be stale
+ * (even once its slot is reused), and the queue must drain in the order of
+ * a sort of the vector.
+ */
+template<class Queue>
+void testHandles(Queue queue, unsigned seed) {
+	typedef typename Queue::Handle Handle;
+	mt19937 rng(seed);
+	uniform_int_distribution<int> priorities(0, 20);
+
+	vector<Expected> live;
+	vector<Handle> handles; // parallel to `live`
+	vector<Handle> gone;
+	size_t order = 0;
+	int nextItem = 0;
+
+	for(int op = 0; op < 20000; op++) {
+		int action = rng() % 16;
+		if(action < 6 || live.empty()) {
+			Expected expected = { priorities(rng), order++, nextItem++ };
+			handles.push_back(queue.insert(expected.mItem, expected.mPriority));
+			live.push_back(expected);
+		} else if(action < 9) {
+			size_t best = 0;
+			for(size_t i = 1; i < live.size(); i++) {
+				if(before(live[i], live[best])) {
+					best = i;
+				}
+			}
+			assert(queue.getTopPriority() == live[best].mPriority);
+			assert(queue.pop_value() == live[best].mItem);
+			gone.push_back(handles[best]);
+			live.erase(live.begin() + best);
+			handles.erase(handles.begin() + best);
+		} else if(action < 12) {
+			// An update keeps the item's place among equal priorities
+			size_t i = rng() % live.size();
+			live[i].mPriority = priorities(rng);
+			queue.update(handles[i], live[i].mPriority);
+			assert(queue.getPriority(handles[i]) == live[i].mPriority);
+		} else {
+			size_t i = rng() % live.size();
+			if(action < 14) {
+				queue.erase(handles[i]);
+			} else {
+				queue.cancel(handles[i]);
+			}
+			gone.push_back(handles[i]);
+			live.erase(live.begin() + i);
+			handles.erase(handles.begin() + i);
+		}
+
+		assert(queue.getSize() == live.size());
+		if(op % 1000 == 0) {
+			for(Handle handle : gone) {
+				assertStale(queue, handle);
+			}
+			for(size_t i = 0; i < live.size(); i++) {
+				assert(queue.contains(handles[i]));
+				assert(queue.getPriority(handles[i]) == live[i].mPriority);
+			}
+			gone.clear();
+		}
+		if(op % 5000 == 0) {
+			// Copies keep the items and their handles
+			Queue copy(queue);
+			queue = copy;
+			queue.shrink_to_fit();
+		}
+	}
+
+	for(Handle handle : gone) {
+		assertStale(queue, handle);
+	}
+	assertStale(queue, Handle());
+
+	sort(live.begin(), live.end(), before);
+	vector<int> drained;
+	queue.drain(back_inserter(drained));
+	assert(drained.size() == live.size());
+	for(size_t i = 0; i < live.size(); i++) {
+		assert(drained[i] == live[i].mItem);
+	}
+	for(Handle handle : handles) {
+		assertStale(queue, handle);
+	}
+}
+
+/**
+ * A handle to a popped item must not find the item that reuses its slot.
+ */
+void testReusedSlot() {
+	PriorityQueue<int, int, std::greater<int>, AddressableLayout<> > queue;
+	auto first = queue.insert(1, 10);
+	queue.pop();
+	auto second = queue.insert(2, 20);
+	assert(first.mSlot == second.mSlot);
+	assertStale(queue, first);
+	assert(queue.contains(second));
+	assert(queue.top() == 2);
+
+	// Cancelled items stay in the heap, but their handles are dead
+	auto third = queue.insert(3, 30);
+	queue.cancel(third);
+	assertStale(queue, third);
+	assert(queue.getSize() == 1);
+	assert(queue.top() == 2);
+}
+
+void testAllHandles() {
+	testReusedSlot();
+	testHandles(PriorityQueue<int, int, std::greater<int>,
+			AddressableLayout<> >(), 1);
+	testHandles(PriorityQueue<int, int, std::greater<int>,
+			AddressableLayout<CompactTriadLayout>, 4, LinearGrowth>(
+					4, LinearGrowth(8)), 2);
+	testHandles(PriorityQueue<int, int, std::greater<int>,
+			AddressableLayout<FusedKeyLayout>, 2, GeometricGrowth>(1), 3);
+	cout << "handles: ok" << endl;
+}
+
+//------------------------------------------------------------------------------
+// FIFO TIES
+//------------------------------------------------------------------------------
+
+/**
+ * Items with equal priorities must leave a BucketQueue in insertion order.
+ */
+void testBucketTies() {
+	BucketQueue<int> highest(0, 9, 2);
+	BucketQueue<int, int, std::less<int> > lowest(0, 9, 2);
+	for(int i = 0; i < 1000; i++) {
+		highest.insert(i, i % 10);
+		lowest.insert(i, i % 10);
+	}
+
+	// Interleave pops and inserts so freed slots get reused
+	for(int i = 0; i < 500; i++) {
+		highest.pop();
+		lowest.pop();
+		highest.insert(1000 + i, 5);
+		lowest.insert(1000 + i, 5);
+	}
+
+	int lastPriority = 10;
+	int lastItem = -1;
+	while(!highest.empty()) {
+		int priority = highest.getTopPriority();
+		int item = highest.pop_value();
+		assert(priority <= lastPriority);
+		assert(priority < lastPriority || item > lastItem);
+		lastPriority = priority;
+		lastItem = item;
+	}
+
+	lastPriority = -1;
+	lastItem = -1;
+	while(!lowest.empty()) {
+		int priority = lowest.getTopPriority();
+		int item = lowest.pop_value();
+		assert(priority >= lastPriority);
+		assert(priority > lastPriority || item > lastItem);
+		lastPriority = priority;
+		lastItem = item;
+	}
+	cout << "bucket ties: ok" << endl;
+}
+
+/**
+ * `clear()` must release a grown BucketQueue's pool, and leave it usable.
+ */
+void testBucketClear() {
+	BucketQueue<int> queue(0, 9, 2);
+	for(int i = 0; i < 1000; i++) {
+		queue.insert(i, i % 10);
+	}
+	assert(queue.getCapacity() >= 1000);
+	queue.clear();
+	assert(queue.empty());
+	assert(queue.getCapacity() == 2);
+	for(int i = 0; i < 10; i++) {
+		queue.insert(i, 3);
+	}
+	for(int i = 0; i < 10; i++) {
+		assert(queue.pop_value() == i);
+	}
+	cout << "bucket clear: ok" << endl;
+}
+
+/**
+ * Items with equal keys must leave a RadixHeap in insertion order, whether
+ * they were inserted at the last key taken out or into a bucket.
+ */
+void testRadixTies() {
+	RadixHeap<int> heap;
+	mt19937 rng(4);
+	vector<pair<uint32_t, int> > expected;
+	int nextItem = 0;
+	uint32_t last = 0;
+	for(int round = 0; round < 200; round++) {
+		for(int i = 0; i < 20; i++) {
+			uint32_t key = last + rng() % 4;
+			heap.insert(nextItem, key);
+			expected.push_back(pair<uint32_t, int>(key, nextItem));
+			nextItem++;
+		}
+
+		// Items go in with increasing numbers, so a stable sort by key is
+		// the order they must come out in
+		stable_sort(expected.begin(), expected.end(),
+				[](const pair<uint32_t, int>& a, const pair<uint32_t, int>& b) {
+			return a.first < b.first;
+		});
+		for(int i = 0; i < 10; i++) {
+			assert(heap.getTopPriority() == expected.front().first);
+			assert(heap.pop_value() == expected.front().second);
+			last = expected.front().first;
+			expected.erase(expected.begin());
+		}
+	}
+	cout << "radix ties: ok" << endl;
+}
+
+// Ids that overflow after 255 insertions, so they're renumbered often
+typedef BasicTriadLayout<uint8_t> TinyIdLayout;
+
+/**
+ * Churns a queue through many id renumberings and checks that ties still
+ * come out first in, first out. With `pinOldest`, the first item stays in
+ * the queue throughout, so renumbering has to sort the nodes rather than
+ * just shift their ids down.
+ */
+template<class Queue>
+void testIdOverflow(Queue queue, bool pinOldest, unsigned seed) {
+	mt19937 rng(seed);
+	vector<pair<int, int> > expected; // (priority, item), in pop order
+	int nextItem = 0;
+	if(pinOldest) {
+		queue.insert(nextItem, -1);
+		expected.push_back(pair<int, int>(-1, nextItem));
+		nextItem++;
+	}
+	for(int round = 0; round < 3000; round++) {
+		int inserts = (queue.getSize() < 40) ? 3 : 1;
+		for(int i = 0; i < inserts; i++) {
+			int priority = rng() % 4;
+			queue.insert(nextItem, priority);
+			expected.push_back(pair<int, int>(priority, nextItem));
+			nextItem++;
+		}
+		stable_sort(expected.begin(), expected.end(),
+				[](const pair<int, int>& a, const pair<int, int>& b) {
+			return a.first > b.first;
+		});
+		for(int i = 0; i < 2; i++) {
+			assert(queue.getTopPriority() == expected.front().first);
+			assert(queue.pop_value() == expected.front().second);
+			expected.erase(expected.begin());
+		}
+	}
+	for(size_t i = 0; i < expected.size(); i++) {
+		assert(queue.pop_value() == expected[i].second);
+	}
+	assert(queue.empty());
+}
+
+void testAllIdOverflows() {
+	for(int pin = 0; pin < 2; pin++) {
+		testIdOverflow(PriorityQueue<int, int, std::greater<int>,
+				TinyIdLayout>(), pin, 5);
+		testIdOverflow(PriorityQueue<int, int, std::greater<int>,
+				TinyIdLayout, 4>(), pin, 6);
+		testIdOverflow(StaticPriorityQueue<int, 64, int, std::greater<int>,
+				TinyIdLayout>(), pin, 7);
+		testIdOverflow(StaticPriorityQueue<int, 64, int, std::greater<int>,
+				TinyIdLayout, 3>(), pin, 8);
+	}
+	cout << "id overflow ties: ok" << endl;
+}
+
+//------------------------------------------------------------------------------
+// DOUBLE-ENDED QUEUES
+//------------------------------------------------------------------------------
+
+/**
+ * Checks a MinMaxPriorityQueue against a multiset through random inserts,
+ * `pop_max()`s and `pop_min()`s, with lots of tied priorities.
+ *
+ * The reference holds (rank, -item) pairs, with rank the priority
+ * oriented so the max end is last. Items are numbered in insertion order,
+ * so with `fifo` the max end takes the oldest of its ties and the min end
+ * the newest, as the pairs sort. Otherwise only the priorities are checked.
+ *
+ * @param sign - 1 if `Compare` puts higher priorities first, -1 if lower
+ */
+template<class Queue>
+void testMinMax(Queue queue, int sign, bool fifo, unsigned seed) {
+	mt19937 rng(seed);
+	multiset<pair<int, int> > expected;
+	int nextItem = 0;
+	for(int op = 0; op < 20000; op++) {
+		// Insert half the time, a bit less once the queue is big
+		unsigned choice = rng() % 8;
+		unsigned inserts = (expected.size() > 200) ? 3 : 4;
+		if(expected.empty() || choice < inserts) {
+			int priority = rng() % 6;
+			queue.insert(nextItem, priority);
+			expected.insert(pair<int, int>(sign*priority, -nextItem));
+			nextItem++;
+		} else if(choice % 2 == 0) {
+			pair<int, int> max = *expected.rbegin();
+			assert(queue.getMaxPriority() == sign*max.first);
+			int item = queue.pop_max_value();
+			if(fifo) {
+				assert(item == -max.second);
+				expected.erase(--expected.end());
+			} else {
+				expected.erase(expected.find(pair<int, int>(max.first, -item)));
+			}
+		} else {
+			pair<int, int> min = *expected.begin();
+			assert(queue.getMinPriority() == sign*min.first);
+			int item = queue.pop_min_value();
+			if(fifo) {
+				assert(item == -min.second);
+				expected.erase(expected.begin());
+			} else {
+				expected.erase(expected.find(pair<int, int>(min.first, -item)));
+			}
+		}
+		assert(queue.getSize() == expected.size());
+		if(!expected.empty()) {
+			assert(queue.getMaxPriority() == sign*expected.rbegin()->first);
+			assert(queue.getMinPriority() == sign*expected.begin()->first);
+		}
+	}
+}
+
+void testAllMinMax() {
+	testMinMax(MinMaxPriorityQueue<int>(), 1, true, 9);
+	testMinMax(MinMaxPriorityQueue<int, int, std::less<int> >(), -1, true, 10);
+	testMinMax(MinMaxPriorityQueue<int, int, std::greater<int>,
+			UnstableLayout>(), 1, false, 11);
+	// Renumbers ids every few hundred inserts, rebuilding the heap
+	testMinMax(MinMaxPriorityQueue<int, int, std::greater<int>,
+			TinyIdLayout>(), 1, true, 12);
+	cout << "min-max: ok" << endl;
+}
+
+//------------------------------------------------------------------------------
+// BOUNDED QUEUES
+//------------------------------------------------------------------------------
+
+/**
+ * Streams random items through a BoundedPriorityQueue and checks what it
+ * keeps against a multiset of the best priorities offered so far, draining
+ * it now and then. Each item is its own (priority, number) pair, so the
+ * drained items show which ones were kept.
+ *
+ * @param sign - 1 if `Compare` puts higher priorities first, -1 if lower
+ */
+template<class Queue>
+void testBounded(Queue queue, int sign, unsigned seed) {
+	mt19937 rng(seed);
+	multiset<int> kept; // sign*priority of each kept item
+	vector<bool> wasKept;
+	for(int round = 0; round < 20; round++) {
+		for(int i = 0; i < 500; i++) {
+			int priority = rng() % 10;
+			int rank = sign*priority;
+			bool better = kept.size() < queue.getBound() ||
+					(queue.getBound() > 0 && rank > *kept.begin());
+			int number = wasKept.size();
+			assert(queue.insert(pair<int, int>(priority, number), priority)
+					== better);
+			wasKept.push_back(better);
+			if(better) {
+				if(kept.size() == queue.getBound()) {
+					kept.erase(kept.begin());
+				}
+				kept.insert(rank);
+			}
+			assert(queue.getSize() == kept.size());
+			assert(queue.full() == (kept.size() == queue.getBound()));
+			if(!kept.empty()) {
+				assert(queue.getWorstPriority() == sign*(*kept.begin()));
+			}
+		}
+
+		// Every drained item was kept when offered, and they come out best
+		// first with exactly the priorities the multiset expects
+		vector<pair<int, int> > drained;
+		queue.drain(back_inserter(drained));
+		assert(queue.empty());
+		assert(drained.size() == kept.size());
+		multiset<int>::reverse_iterator rank = kept.rbegin();
+		for(size_t i = 0; i < drained.size(); i++, ++rank) {
+			assert(sign*drained[i].first == *rank);
+			assert(wasKept[drained[i].second]);
+			wasKept[drained[i].second] = false;
+		}
+		kept.clear();
+	}
+}
+
+void testAllBounded() {
+	size_t bounds[] = { 0, 1, 7, 64 };
+	for(size_t bound : bounds) {
+		testBounded(BoundedPriorityQueue<pair<int, int> >(bound), 1, 13);
+		testBounded(BoundedPriorityQueue<pair<int, int>, int,
+				std::less<int> >(bound), -1, 14);
+		testBounded(BoundedPriorityQueue<pair<int, int>, int,
+				std::greater<int>, TriadLayout, 4>(bound), 1, 15);
+	}
+	cout << "bounded: ok" << endl;
+}
+
+//------------------------------------------------------------------------------
+// TIMERS
+//------------------------------------------------------------------------------
+
+typedef TimerScheduler<int> Timers;
+
+/**
+ * Timers on every level of the wheels and beyond must run exactly when
+ * their tick comes, not a tick early.
+ */
+void testTimerLevels() {
+	steady_clock::time_point origin = steady_clock::now();
+	Timers timers(milliseconds(1), origin);
+	vector<uint64_t> ticks = { 0, 1, 2, 63, 64, 65, 127, 128, 4095, 4096,
+			4097, 262143, 262144, 262145, 16777215, 16777216, 16777216 + 64*5 + 3,
+			50000000 };
+	for(size_t i = 0; i < ticks.size(); i++) {
+		timers.schedule_at(origin + milliseconds(ticks[i]), static_cast<int>(i));
+	}
+
+	vector<int> ran;
+	auto collect = [&ran](int& item) { ran.push_back(item); };
+	for(size_t i = 0; i < ticks.size(); i++) {
+		if(ticks[i] > 0) {
+			assert(timers.run_due(origin + milliseconds(ticks[i] - 1), collect)
+					== 0);
+		}
+		assert(timers.next_wakeup() <= origin + milliseconds(ticks[i]));
+		assert(timers.run_due(origin + milliseconds(ticks[i]), collect) == 1);
+		assert(ran.back() == static_cast<int>(i));
+	}
+	assert(timers.empty());
+	assert(timers.next_wakeup() == steady_clock::time_point::max());
+	cout << "timer levels: ok" << endl;
+}
+
+/**
+ * A deadline of `TimePoint::max()` must never come, and mustn't overflow
+ * the tick arithmetic on the way.
+ */
+void testTimerNever() {
+	steady_clock::time_point origin = steady_clock::now();
+	Timers timers(milliseconds(3), origin);
+	Timers::Handle never =
+			timers.schedule_at(steady_clock::time_point::max(), 1);
+	timers.schedule_at(origin + milliseconds(10), 2);
+
+	steady_clock::time_point wakeup = timers.next_wakeup();
+	assert(wakeup > origin && wakeup <= origin + milliseconds(12));
+	vector<int> ran;
+	auto collect = [&ran](int& item) { ran.push_back(item); };
+	assert(timers.run_due(origin + milliseconds(12), collect) == 1);
+	assert(ran.back() == 2);
+
+	// Nothing comes due, even at the end of time
+	wakeup = timers.next_wakeup();
+	assert(wakeup > origin + milliseconds(12));
+	assert(timers.run_due(steady_clock::time_point::max(), collect) == 0);
+	assert(timers.pending(never));
+	assert(timers.next_wakeup() >= wakeup);
+	assert(timers.cancel(never));
+	assert(timers.next_wakeup() == steady_clock::time_point::max());
+
+	// A deadline just short of it isn't run early
+	Timers fresh(milliseconds(3), origin);
+	Timers::Handle late = fresh.schedule_at(
+			steady_clock::time_point::max() - milliseconds(1), 3);
+	assert(fresh.run_due(steady_clock::time_point::max() - milliseconds(4),
+			collect) == 0);
+	assert(fresh.pending(late));
+	cout << "timer never: ok" << endl;
+}
+
+/**
+ * Schedules and cancels timers at random distances while time jumps ahead
+ * by random steps. Each call to `run_due()` must run exactly the timers due
+ * by then, in order of their ticks.
+ */
+void testTimerCascade() {
+	steady_clock::time_point origin = steady_clock::now();
+	Timers timers(milliseconds(1), origin);
+	mt19937 rng(5);
+
+	vector<uint64_t> deadlines;
+	vector<Timers::Handle> handles;
+	vector<bool> pending;
+	uint64_t now = 0;
+
+	for(int round = 0; round < 3000; round++) {
+		for(int i = rng() % 8; i > 0; i--) {
+			// Spread the delays over every level and the overflow
+			uint64_t delay = rng() % (uint64_t(1) << (rng() % 27));
+			deadlines.push_back(now + delay);
+			handles.push_back(timers.schedule_at(
+					origin + milliseconds(now + delay),
+					static_cast<int>(deadlines.size() - 1)));
+			pending.push_back(true);
+		}
+		for(int i = rng() % 3; i > 0; i--) {
+			size_t victim = rng() % handles.size();
+			assert(timers.cancel(handles[victim]) == pending[victim]);
+			pending[victim] = false;
+			assert(!timers.pending(handles[victim]));
+		}
+
+		int jump = rng() % 4;
+		now += (jump == 0) ? rng() % 4
+				: (jump == 1) ? rng() % 5000
+				: (jump == 2) ? rng() % 300000 : rng() % (uint64_t(1) << 25);
+
+		vector<int> ran;
+		timers.run_due(origin + milliseconds(now),
+				[&ran](int& item) { ran.push_back(item); });
+		vector<int> due;
+		for(size_t i = 0; i < deadlines.size(); i++) {
+			if(pending[i] && deadlines[i] <= now) {
+				due.push_back(static_cast<int>(i));
+			}
+		}
+		for(size_t i = 1; i < ran.size(); i++) {
+			assert(deadlines[ran[i - 1]] <= deadlines[ran[i]]);
+		}
+		sort(ran.begin(), ran.end());
+		assert(ran == due);
+		for(int i : ran) {
+			pending[i] = false;
+			assert(!timers.pending(handles[i]));
+			assert(!timers.cancel(handles[i]));
+		}
+
+		size_t numPending = 0;
+		for(size_t i = 0; i < pending.size(); i++) {
+			numPending += pending[i];
+		}
+		assert(timers.getSize() == numPending);
+	}
+	cout << "timer cascade: ok" << endl;
+}
+
+//------------------------------------------------------------------------------
+// CONCURRENT QUEUES
+//------------------------------------------------------------------------------
+
+/**
+ * An item whose copy constructor throws while `sFailCopies` is set.
+ */
+struct Fragile {
+	static bool sFailCopies;
+
+	int mValue;
+
+	Fragile() : mValue(0) {}
+	explicit Fragile(int value) : mValue(value) {}
+	Fragile(const Fragile& src) : mValue(src.mValue) {
+		if(sFailCopies) {
+			throw runtime_error("copy failed");
+		}
+	}
+	Fragile(Fragile&&) = default;
+	Fragile& operator=(const Fragile&) = default;
+	Fragile& operator=(Fragile&&) = default;
+};
+
+bool Fragile::sFailCopies = false;
+
+/**
+ * Waits up to a few seconds for `work`, which would block forever on a
+ * shard left locked, and asserts that it finished.
+ */
+void assertFinishes(future<void>& work) {
+	assert(work.wait_for(std::chrono::seconds(5)) == future_status::ready);
+	work.get();
+}
+
+/**
+ * An insert that throws must leave its shard unlocked and the queue usable.
+ */
+void testMultiQueueInsertThrows() {
+	// One shard, so every insert and pop lands on the one that threw
+	MultiQueue<Fragile> queue(1);
+	queue.insert(Fragile(1), 1);
+
+	Fragile::sFailCopies = true;
+	bool threw = false;
+	try {
+		Fragile item(2);
+		queue.insert(item, 2);
+	} catch(const runtime_error&) {
+		threw = true;
+	}
+	Fragile::sFailCopies = false;
+	assert(threw);
+
+	future<void> work = async(std::launch::async, [&queue] {
+		queue.insert(Fragile(3), 3);
+		Fragile item;
+		assert(queue.try_pop(item) && item.mValue == 3);
+		assert(queue.try_pop(item) && item.mValue == 1);
+		assert(!queue.try_pop(item));
+	});
+	assertFinishes(work);
+	cout << "multiqueue insert throws: ok" << endl;
+}
+
+/**
+ * With a single shard, a MultiQueue's order is exact: priority order, ties
+ * first in, first out.
+ */
+void testMultiQueueOneShard() {
+	MultiQueue<int> queue(1);
+	mt19937 rng(16);
+	vector<pair<int, int> > expected;
+	for(int i = 0; i < 2000; i++) {
+		int priority = rng() % 16;
+		queue.insert(i, priority);
+		expected.push_back(pair<int, int>(priority, i));
+	}
+	stable_sort(expected.begin(), expected.end(),
+			[](const pair<int, int>& a, const pair<int, int>& b) {
+		return a.first > b.first;
+	});
+	for(size_t i = 0; i < expected.size(); i++) {
+		int item;
+		assert(queue.try_pop(item) && item == expected[i].second);
+	}
+	int item;
+	assert(queue.empty() && !queue.try_pop(item));
+	cout << "multiqueue one shard: ok" << endl;
+}
+
+/**
+ * Producers and consumers hammer a MultiQueue at once. However relaxed the
+ * order, every item inserted must come out exactly once.
+ */
+void testMultiQueueConcurrent() {
+	static const int PRODUCERS = 4;
+	static const int CONSUMERS = 3;
+	static const int ITEMS_PER_PRODUCER = 20000;
+	MultiQueue<int> queue(8);
+	atomic<bool> produced(false);
+
+	vector<vector<int> > popped(CONSUMERS);
+	vector<thread> consumers;
+	for(int c = 0; c < CONSUMERS; c++) {
+		consumers.push_back(thread([&queue, &produced, &popped, c] {
+			while(true) {
+				// Read the flag first: once it's set, an empty queue stays so
+				bool done = produced.load();
+				int item;
+				if(queue.try_pop(item)) {
+					popped[c].push_back(item);
+				} else if(done) {
+					return;
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		}));
+	}
+
+	vector<thread> producers;
+	for(int p = 0; p < PRODUCERS; p++) {
+		producers.push_back(thread([&queue, p] {
+			mt19937 rng(17 + p);
+			for(int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+				queue.insert(p*ITEMS_PER_PRODUCER + i, rng() % 100);
+			}
+		}));
+	}
+	for(size_t p = 0; p < producers.size(); p++) {
+		producers[p].join();
+	}
+	produced.store(true);
+	for(size_t c = 0; c < consumers.size(); c++) {
+		consumers[c].join();
+	}
+
+	vector<int> seen(PRODUCERS*ITEMS_PER_PRODUCER, 0);
+	for(int c = 0; c < CONSUMERS; c++) {
+		for(size_t i = 0; i < popped[c].size(); i++) {
+			seen[popped[c][i]]++;
+		}
+	}
+	for(size_t i = 0; i < seen.size(); i++) {
+		assert(seen[i] == 1);
+	}
+	assert(queue.empty());
+	cout << "multiqueue concurrent: ok" << endl;
+}
+
+/**
+ * A BlockingPriorityQueue on one thread: exact order, the bound, timeouts
+ * and closing.
+ */
+void testBlockingSingleThread() {
+	BlockingPriorityQueue<int> queue(4);
+	assert(queue.try_push(1, 5) && queue.push(2, 7));
+	vector<pair<int, int> > entries;
+	entries.push_back(pair<int, int>(3, 5));
+	entries.push_back(pair<int, int>(4, 9));
+	assert(queue.push_range(entries.begin(), entries.end()) == 2);
+	assert(queue.getSize() == 4 && !queue.try_push(5, 9));
+
+	// Priority order, ties first in, first out
+	int item;
+	assert(queue.pop_wait(item) && item == 4);
+	vector<int> popped;
+	assert(queue.pop_n_wait(2, back_inserter(popped)) == 2);
+	assert(popped[0] == 2 && popped[1] == 1);
+	assert(queue.try_pop(item) && item == 3);
+	assert(!queue.try_pop(item));
+	assert(!queue.pop_for(item, milliseconds(10)));
+
+	// Once closed, pushes fail and pops take what's left, then fail
+	assert(queue.push(6, 1));
+	queue.close();
+	assert(queue.closed() && !queue.push(7, 1) && !queue.try_push(7, 1));
+	assert(queue.push_range(entries.begin(), entries.end()) == 0);
+	assert(queue.pop_wait(item) && item == 6);
+	assert(!queue.pop_wait(item) && !queue.pop_for(item, milliseconds(10)));
+	assert(queue.pop_n_wait(2, back_inserter(popped)) == 0);
+	cout << "blocking single thread: ok" << endl;
+}
+
+/**
+ * `close()` must wake consumers waiting on an empty queue and producers
+ * waiting on a full one.
+ */
+void testBlockingCloseWakes() {
+	BlockingPriorityQueue<int> queue(1);
+	assert(queue.push(1, 1));
+	future<void> push = async(std::launch::async, [&queue] {
+		assert(!queue.push(2, 2));
+	});
+	BlockingPriorityQueue<int> empty;
+	future<void> pop = async(std::launch::async, [&empty] {
+		int item;
+		assert(!empty.pop_wait(item));
+	});
+	std::this_thread::sleep_for(milliseconds(20));
+	queue.close();
+	empty.close();
+	assertFinishes(push);
+	assertFinishes(pop);
+	cout << "blocking close wakes: ok" << endl;
+}
+
+/**
+ * Producers and consumers share a small bounded queue, through every push
+ * and pop method, until it's closed. Every item must come out exactly once.
+ */
+void testBlockingConcurrent() {
+	static const int PRODUCERS = 3;
+	static const int CONSUMERS = 3;
+	static const int ITEMS_PER_PRODUCER = 10000;
+	BlockingPriorityQueue<int> queue(16);
+
+	vector<vector<int> > popped(CONSUMERS);
+	vector<thread> consumers;
+	for(int c = 0; c < CONSUMERS; c++) {
+		consumers.push_back(thread([&queue, &popped, c] {
+			int item;
+			if(c == 0) {
+				while(queue.pop_n_wait(5, back_inserter(popped[c])) > 0) {}
+			} else if(c == 1) {
+				while(queue.pop_wait(item)) {
+					popped[c].push_back(item);
+				}
+			} else {
+				while(!queue.closed() || !queue.empty()) {
+					if(queue.pop_for(item, milliseconds(1))) {
+						popped[c].push_back(item);
+					}
+				}
+			}
+		}));
+	}
+
+	vector<thread> producers;
+	for(int p = 0; p < PRODUCERS; p++) {
+		producers.push_back(thread([&queue, p] {
+			int first = p*ITEMS_PER_PRODUCER;
+			if(p == 0) {
+				vector<pair<int, int> > entries;
+				for(int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+					entries.push_back(pair<int, int>(first + i, i % 7));
+				}
+				assert(queue.push_range(entries.begin(), entries.end())
+						== entries.size());
+			} else {
+				for(int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+					assert(queue.push(first + i, i % 7));
+				}
+			}
+		}));
+	}
+	for(size_t p = 0; p < producers.size(); p++) {
+		producers[p].join();
+	}
+	queue.close();
+	for(size_t c = 0; c < consumers.size(); c++) {
+		consumers[c].join();
+	}
+
+	vector<int> seen(PRODUCERS*ITEMS_PER_PRODUCER, 0);
+	for(int c = 0; c < CONSUMERS; c++) {
+		for(size_t i = 0; i < popped[c].size(); i++) {
+			seen[popped[c][i]]++;
+		}
+	}
+	for(size_t i = 0; i < seen.size(); i++) {
+		assert(seen[i] == 1);
+	}
+	assert(queue.empty());
+	cout << "blocking concurrent: ok" << endl;
+}
+
+} // namespace test
+
+int main() {
+	test::testAllHandles();
+	test::testBucketTies();
+	test::testBucketClear();
+	test::testRadixTies();
+	test::testAllIdOverflows();
+	test::testAllMinMax();
+	test::testAllBounded();
+	test::testTimerLevels();
+	test::testTimerNever();
+	test::testTimerCascade();
+	test::testMultiQueueInsertThrows();
+	test::testMultiQueueOneShard();
+	test::testMultiQueueConcurrent();
+	test::testBlockingSingleThread();
+	test::testBlockingCloseWakes();
+	test::testBlockingConcurrent();
+	cout << "All tests passed." << endl;
+	return 0;
+}